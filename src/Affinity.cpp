@@ -0,0 +1,220 @@
+#include "Affinity.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <dirent.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+#define AFFINITY_MAX_NODES  1024
+
+Affinity::Affinity()
+{
+    streamPolicy  = AFFINITY_NONE;
+    controlPolicy = AFFINITY_NONE;
+}
+
+bool Affinity::Set(const char* spec , uint8_t* policy , std::vector<int>* cpus)
+{
+    cpus->clear();
+
+    if(!strcmp(spec , "nic"))
+    {
+        *policy = AFFINITY_NIC;
+        return true;
+    }
+
+    if(!ParseCpuList(spec , cpus))
+        return false;
+
+    *policy = AFFINITY_CPUS;
+    return true;
+}
+
+bool Affinity::SetStreams(const char* spec)
+{
+    return Set(spec , &streamPolicy , &streamCpus);
+}
+
+bool Affinity::SetControl(const char* spec)
+{
+    return Set(spec , &controlPolicy , &controlCpus);
+}
+
+bool Affinity::UsesNic()
+{
+    return (streamPolicy == AFFINITY_NIC || controlPolicy == AFFINITY_NIC);
+}
+
+bool Affinity::PinsStreams()
+{
+    return (streamPolicy != AFFINITY_NONE);
+}
+
+void Affinity::Resolve(const std::string& ifName)
+{
+    std::vector<int> nodeCpus;
+
+    if(!UsesNic())
+        return;
+
+    //The CPUs of the node that the NIC is attached to
+    int node = GetInterfaceNode(ifName);
+    if(node < 0)
+        fprintf(stderr, "[NERF ~ INFO] : %s has no NUMA node , the \"nic\" threads are not pinned.\n", ifName.c_str());
+    else
+    {
+        std::string cpuList;
+        char        path[128];
+
+        snprintf(path , sizeof(path) , "/sys/devices/system/node/node%d/cpulist" , node);
+
+        FILE* file = fopen(path , "r");
+        if(file)
+        {
+            char line[4096];
+
+            if(fgets(line , sizeof(line) , file))
+                ParseCpuList(line , &nodeCpus);
+            fclose(file);
+        }
+    }
+
+    if(streamPolicy == AFFINITY_NIC)
+        streamCpus = nodeCpus;
+    if(controlPolicy == AFFINITY_NIC)
+        controlCpus = nodeCpus;
+}
+
+void Affinity::PinStream(uint32_t index)
+{
+    if(streamCpus.empty())
+        return;
+
+    int cpu    = streamCpus[index % streamCpus.size()];
+    int result = PinThread(std::vector<int>(1 , cpu));
+
+    if(result)
+    {
+        fprintf(stderr, "[NERF ~ INFO] : unable to pin a stream thread: %s\n", strerror(result));
+        return;
+    }
+
+    SetMemoryNode(GetCpuNode(cpu));
+}
+
+void Affinity::PinControl()
+{
+    if(controlCpus.empty())
+        return;
+
+    int result = PinThread(controlCpus);
+
+    if(result)
+        fprintf(stderr, "[NERF ~ INFO] : unable to pin the control thread: %s\n", strerror(result));
+}
+
+// =======================================================================================================================================
+// ================================================== Topology ===========================================================================
+// =======================================================================================================================================
+
+bool Affinity::ParseCpuList(const char* list , std::vector<int>* cpus)
+{
+    const char* position = list;
+
+    //The kernel format , "0-3,8,10-11"
+    while(*position && *position != '\n')
+    {
+        char* end;
+        long  first = strtol(position , &end , 10);
+        long  last  = first;
+
+        if(end == position || first < 0 || first >= CPU_SETSIZE)
+            return false;
+
+        if(*end == '-')
+        {
+            position = end + 1;
+            last     = strtol(position , &end , 10);
+
+            if(end == position || last < first || last >= CPU_SETSIZE)
+                return false;
+        }
+
+        for(long cpu = first; cpu <= last; cpu++)
+            cpus->push_back(cpu);
+
+        if(*end == ',')
+            end++;
+        else if(*end && *end != '\n')
+            return false;
+
+        position = end;
+    }
+
+    return !cpus->empty();
+}
+
+int Affinity::GetInterfaceNode(const std::string& ifName)
+{
+    char path[128];
+    int  node = -1;
+
+    //Only devices (not "lo" , bridges , veths) have a node , and only on NUMA machines
+    snprintf(path , sizeof(path) , "/sys/class/net/%s/device/numa_node" , ifName.c_str());
+
+    FILE* file = fopen(path , "r");
+    if(!file)
+        return -1;
+
+    if(fscanf(file , "%d" , &node) != 1)
+        node = -1;
+    fclose(file);
+
+    return node;
+}
+
+int Affinity::GetCpuNode(int cpu)
+{
+    char path[128];
+    int  node = -1;
+
+    //The cpu directory holds a "node<N>" link to its node
+    snprintf(path , sizeof(path) , "/sys/devices/system/cpu/cpu%d" , cpu);
+
+    DIR* directory = opendir(path);
+    if(!directory)
+        return -1;
+
+    for(struct dirent* entry = readdir(directory); entry; entry = readdir(directory))
+        if(!strncmp(entry->d_name , "node" , 4) && sscanf(entry->d_name + 4 , "%d" , &node) == 1)
+            break;
+    closedir(directory);
+
+    return node;
+}
+
+int Affinity::PinThread(const std::vector<int>& cpus)
+{
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    for(int cpu : cpus)
+        CPU_SET(cpu , &set);
+
+    return pthread_setaffinity_np(pthread_self() , sizeof(cpu_set_t) , &set);
+}
+
+bool Affinity::SetMemoryNode(int node)
+{
+    unsigned long mask[AFFINITY_MAX_NODES / (8 * sizeof(unsigned long))];
+
+    if(node < 0 || node >= AFFINITY_MAX_NODES)
+        return false;
+
+    memset(mask , 0 , sizeof(mask));
+    mask[node / (8 * sizeof(unsigned long))] |= (1UL << (node % (8 * sizeof(unsigned long))));
+
+    //No libnuma , the system call is all that is needed. Preferred (not bound) , a full node falls back to the others.
+    return !syscall(SYS_set_mempolicy , MPOL_PREFERRED , mask , AFFINITY_MAX_NODES + 1);
+}
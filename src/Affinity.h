@@ -0,0 +1,65 @@
+#ifndef _AFFINITY_H_
+#define _AFFINITY_H_
+
+#include "Utilities.h"
+
+#define AFFINITY_NONE   0   // the scheduler places the threads
+#define AFFINITY_CPUS   1   // an explicit CPU list
+#define AFFINITY_NIC    2   // the CPUs of the NUMA node that the interface sits on
+
+//Where the stream threads and the TCP control thread run. A stream thread gets a single CPU
+//(round robin over the list) and prefers the memory of its node , so whatever it allocates
+//after it is pinned (buffers , measurements) is local to it.
+//
+//   --affinity 0-3,8 , --affinity nic , --control-affinity 9
+//
+class Affinity
+{
+private:
+    uint8_t          streamPolicy;
+    std::vector<int> streamCpus;
+
+    uint8_t          controlPolicy;
+    std::vector<int> controlCpus;
+
+    bool Set(const char* spec , uint8_t* policy , std::vector<int>* cpus);
+
+public:
+    Affinity();
+
+    //"nic" or a CPU list ("0-3,8")
+    bool SetStreams(const char* spec);
+
+    bool SetControl(const char* spec);
+
+    bool UsesNic();
+
+    bool PinsStreams();
+
+    //Turns the "nic" policies into the CPUs of the node of "ifName" (once the interface is known)
+    void Resolve(const std::string& ifName);
+
+    //Pins the calling thread , the streams take the CPUs in turn
+    void PinStream(uint32_t index);
+
+    void PinControl();
+
+    // =======================================================================================================================================
+    // ================================================== Topology ===========================================================================
+    // =======================================================================================================================================
+
+    static bool ParseCpuList(const char* list , std::vector<int>* cpus);
+
+    //-1 when the interface is virtual or the machine has a single node
+    static int GetInterfaceNode(const std::string& ifName);
+
+    static int GetCpuNode(int cpu);
+
+    //0 , or the error of pthread_setaffinity_np (it does not set errno)
+    static int PinThread(const std::vector<int>& cpus);
+
+    //The pages that the calling thread touches first come from "node" (if it has free memory)
+    static bool SetMemoryNode(int node);
+};
+
+#endif
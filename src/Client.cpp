@@ -1,4 +1,5 @@
 #include "Client.h"
+#include "SocketOptions.h"
 
 // ======================================================================================================================================= 
 // ================================================== Constructors ======================================================================= 
@@ -40,12 +41,27 @@ Client::Client(uint16_t _port , const char* _ip)
 void Client::Setup()
 {
     udpPacketSize             = DEFAULT_UDP_PACKET_SIZE;
+    batchSize                 = DEFAULT_BATCH_SIZE;
+    burstSize                 = DEFAULT_BURST_SIZE;
+    socketBufferCap           = DEFAULT_SOCKET_BUFFER_CAP;
+    pacingMode                = PACING_USER;
+    useGso                    = 0;
+    useZeroCopy               = 0;
+    useHugePages              = 0;
+    useIoUring                = 0;
+    numberOfSenderThreads     = DEFAULT_SENDER_THREADS;
+    txTimeUsesTai             = false;
     numberOfParallelStreams   = DEFAULT_NUMBER_OF_PARALLEL_STREAMS;
     measureOneWay             = DEFAULT_MEASURE_ONE_WAY;
     bandwidth                 = DEFAULT_BANDWIDTH;
     printResultsInterval      = DEFAULT_INTERVAL_TO_PRINT;
+    printResultInter          = 0;
     testAccordingToTime       = 0;
     durationInSeconds         = 0;
+    streamsStartTime          = 0;
+    searching                 = false;
+    searchStopped             = false;
+    searchLossThreshold       = 0.0f;
 
     serverPort = DEFAULT_SERVER_PORT_TO_SEND;
     serverIp   = NULL;
@@ -105,18 +121,105 @@ void Client::SetVariables(uint32_t _udpPacketSize,
     if(_printResultsInterval)
         printResultsInterval = _printResultsInterval;
 
-    //Send the "setup" parameters to the server
-    NerfPacket setupPacket = NerfPacket::MakeSetupPacket(udpPacketSize,numberOfParallelStreams,measureOneWay,printResultsInterval,_printResultInter);
-    TCPSend(setupPacket);
-    //Wait to recv the open ports that the client create
-    TCPRecv();
+    printResultInter = _printResultInter;
+}
+
+void Client::SetBatchSize(uint32_t _batchSize)
+{
+    if(_batchSize)
+        batchSize = std::min<uint32_t>(_batchSize , MAX_BATCH_SIZE);
+}
+
+void Client::SetBurstSize(uint32_t _burstSize)
+{
+    if(_burstSize)
+        burstSize = _burstSize;
+}
+
+void Client::SetPacingMode(uint8_t _pacingMode)
+{
+    pacingMode = _pacingMode;
+}
+
+void Client::SetGso(uint8_t _useGso)
+{
+    useGso = _useGso;
+}
+
+void Client::SetZeroCopy(uint8_t _useZeroCopy)
+{
+    useZeroCopy = _useZeroCopy;
+}
+
+void Client::SetHugePages(uint8_t _useHugePages)
+{
+    useHugePages = _useHugePages;
+}
+
+void Client::SetIoUring(uint8_t _useIoUring)
+{
+    useIoUring = _useIoUring;
+}
+
+void Client::SetSocketBufferCap(uint32_t _socketBufferCap)
+{
+    socketBufferCap = _socketBufferCap;
+}
+
+void Client::SetSenderThreads(uint32_t _numberOfSenderThreads)
+{
+    numberOfSenderThreads = _numberOfSenderThreads;
+}
+
+void Client::SetProfile(const TrafficProfile& _profile)
+{
+    profile = _profile;
+}
+
+void Client::SetAffinity(const Affinity& _affinity)
+{
+    affinity = _affinity;
+}
+
+void Client::SetSearch(double _lossThreshold , std::vector<uint32_t> _packetSizes)
+{
+    searching           = true;
+    searchLossThreshold = _lossThreshold;
+    searchPacketSizes   = _packetSizes;
+
+    //Every trial is a timed test , the server must not send measurements in the middle of it
+    numberOfParallelStreams = std::max<uint16_t>(numberOfParallelStreams , 1);
+    testAccordingToTime     = 1;
+    printResultInter        = 0;
+
+    if(!durationInSeconds)
+        durationInSeconds = SEARCH_DEFAULT_TRIAL;
+}
+
+void Client::StopSearch()
+{
+    searchStopped = true;
 }
 
 void Client::CleanUp()
 {
     if(socketTcpId > 0)
         close(socketTcpId);
+
+    CleanUpStreams();
+
+    if(tcpbuffer)
+        delete [] tcpbuffer;
     
+    if(resultsFile)
+        fclose(resultsFile);
+
+    FD_ZERO(&readDescriptors);
+    FD_ZERO(&writeDescriptors);
+}
+
+void Client::CleanUpStreams()
+{
     for(auto socket : openSockets)
         if(socket >= 0)
             close(socket);
@@ -129,18 +232,14 @@ void Client::CleanUp()
     for(auto thread : openStreams)
         delete thread;
     openStreams.clear();
+
+    for(auto worker : senderWorkers)
+        delete worker;
+    senderWorkers.clear();
     
     addressedToSendData.clear();
     serverOpenPorts.clear();
-
-    if(tcpbuffer)
-        delete [] tcpbuffer;
-    
-    if(resultsFile)
-        fclose(resultsFile);
-
-    FD_ZERO(&readDescriptors);
-    FD_ZERO(&writeDescriptors);
+    phaseResults.clear();
 }
 
 // ======================================================================================================================================= 
@@ -195,13 +294,81 @@ ClientStreamParams* Client::CreateUdpClient(uint16_t serverOpenPort)
 
     params->socketId          = socketId;
     params->port              = serverOpenPort;
-    params->bandwidth         = bandwidth;
-    params->durationInSeconds = durationInSeconds;
     params->serverToSendData  = serverToSendUpdData;
-    params->stop              = false;
     params->udpPacketSize     = udpPacketSize;
-    params->udpSeqNumber      = 0;
-    params->totalBytesSend    = 0;
+    params->batchSize         = batchSize;
+
+    if(useGso)
+    {
+        //As many segments as the kernel takes in a single UDP_SEGMENT super buffer
+        uint32_t segments = std::min<uint32_t>(GSO_MAX_SEGMENTS , GSO_MAX_BYTES / udpPacketSize);
+
+        if(segments < 2)
+            fprintf(stderr, "[UDP CLIENT ~ INFO] : packets of %u bytes are too large for GSO.\n", udpPacketSize);
+        else if(!SocketOptions::SetUdpSegment(socketId , udpPacketSize))
+            perror("[UDP CLIENT ~ INFO] : UDP_SEGMENT , falling back to one datagram per message");
+        else
+        {
+            params->gsoSegments = segments;
+
+            //GSO packs the batch , so a batch smaller than a super buffer would waste it
+            params->batchSize = std::max(params->batchSize , segments);
+        }
+    }
+
+    if(useZeroCopy)
+    {
+        if(SocketOptions::SetZeroCopy(socketId))
+            params->useZeroCopy = 1;
+        else
+            perror("[UDP CLIENT ~ INFO] : SO_ZEROCOPY , falling back to copying sends");
+    }
+
+    //A profile starts at the rate of its first phase
+    uint64_t resume;
+    uint64_t streamBandwidth = profile.IsEmpty() ? bandwidth : profile.GetBandwidth(0 , &resume);
+
+    //A burst smaller than a batch could never be released
+    params->pacer.Setup(streamBandwidth ? streamBandwidth : bandwidth , std::max(burstSize , params->batchSize) * udpPacketSize);
+
+    //Room for a couple of bursts , a sender blocked on its send buffer falls behind its schedule
+    uint64_t burstBytes = (uint64_t)std::max(burstSize , params->batchSize) * (udpPacketSize + HEADERS_FROM_THE_LAYERS) * 4;
+    if(!SocketOptions::GrowBuffer(socketId , false , std::min<uint64_t>(burstBytes , socketBufferCap)))
+        perror("[UDP CLIENT ~ INFO] : SO_SNDBUF");
+
+    if(pacingMode == PACING_RATE)
+    {
+        //fq paces what it sees on the wire , so scale the rate up by the headers below UDP
+        uint64_t wireBytesPerSecond = (bandwidth / 8) * (udpPacketSize + UDP_HEADER_SIZE + IPV4_HEADER_SIZE + ETH_MAC_HEADER_SIZE) / udpPacketSize;
+
+        if(SocketOptions::SetMaxPacingRate(socketId , wireBytesPerSecond))
+            params->pacingMode = PACING_RATE;
+        else
+            perror("[UDP CLIENT ~ INFO] : SO_MAX_PACING_RATE , falling back to userspace pacing");
+    }
+    else if(pacingMode == PACING_TXTIME)
+    {
+        //fq works with CLOCK_MONOTONIC launch times , etf wants CLOCK_TAI
+        clockid_t clock = txTimeUsesTai ? CLOCK_TAI : CLOCK_MONOTONIC;
+
+        if(SocketOptions::SetTxTime(socketId , clock))
+        {
+            params->pacingMode = PACING_TXTIME;
+
+            if(txTimeUsesTai)
+            {
+                Time tai;
+                Time monotonic;
+
+                clock_gettime(CLOCK_TAI , &tai);
+                SystemClock::GetSystemTime(&monotonic);
+
+                params->txTimeOffset = SystemClock::GetTimeInNanoSeconds(&tai) - SystemClock::GetTimeInNanoSeconds(&monotonic);
+            }
+        }
+        else
+            perror("[UDP CLIENT ~ INFO] : SO_TXTIME , falling back to userspace pacing");
+    }
 
     addressedToSendData.push_back(serverToSendUpdData);
     openSockets.push_back(socketId);
@@ -210,89 +377,75 @@ ClientStreamParams* Client::CreateUdpClient(uint16_t serverOpenPort)
     return params;
 }
 
-void Client::CreateStream(uint16_t serverOpenPort)
+bool Client::GetEgressInterface(int* ifIndex , std::string* ifName)
 {
-    auto senderHandler = [](ClientStreamParams* params)
-    {
-        uint8_t  udpBuffer[params->udpPacketSize];
+    struct sockaddr_in destination;
 
-        Time bandwidthTimeBegin;
-        Time bandwidthTimeEnd;
+    memset(&destination , 0 , sizeof(struct sockaddr_in));
+    destination.sin_family      = AF_INET;
+    destination.sin_port        = htons(serverPort);
+    destination.sin_addr.s_addr = inet_addr(serverIp ? serverIp : DEFAULT_SERVER_IP_TO_SEND);
 
-        Time stopTestBegin;
-        Time stopTestEnd;
-        Time sendTime;
-        Time diff;
+    return SocketOptions::GetEgressInterface(&destination , ifIndex , ifName);
+}
 
-        uint64_t numberOfPacketsToSend = ((params->bandwidth / 8) / params->udpPacketSize);
-        uint32_t remainingBytesToSend  = ((params->bandwidth / 8) - (numberOfPacketsToSend * params->udpPacketSize));
+void Client::CheckKernelPacing()
+{
+    std::string ifName;
+    int ifIndex;
 
-        auto UDPSend = [&](uint32_t bytesToSend)
-        {
-            int64_t     bytesSend;
+    if(pacingMode == PACING_USER)
+        return;
 
-            params->udpSeqNumber++;
-            
-            uint64_t sendSeq = reverseBytes(params->udpSeqNumber);
-            memcpy(udpBuffer, &sendSeq , sizeof(uint64_t));
-            
-            SystemClock::GetSystemTime(&sendTime);
-            SystemClock::Serialize(&sendTime, udpBuffer, sizeof(uint64_t));
-
-            bytesSend = sendto(params->socketId , udpBuffer , bytesToSend , 0 , (struct sockaddr*)&params->serverToSendData, sizeof(struct sockaddr_in));
-            if(bytesSend <= 0)
-                fprintf(stderr, "[UDP CLIENT ~ ERROR] : Something went wrong while trying to send data!\n");
-            else 
-                params->totalBytesSend += bytesSend; 
-        };
+    //SO_MAX_PACING_RATE is a single rate , SO_TXTIME follows any schedule
+    if(pacingMode == PACING_RATE && !profile.IsEmpty())
+    {
+        fprintf(stderr, "[UDP CLIENT ~ INFO] : a traffic profile changes the rate , falling back to userspace pacing.\n");
+        pacingMode = PACING_USER;
+        return;
+    }
 
-        auto CheckTime = [&]()-> bool 
-        {
-            if(params->durationInSeconds)
-            {
-                SystemClock::GetSystemTime(&stopTestEnd);
-                
-                diff = SystemClock::GetElapsedTime(&stopTestBegin , &stopTestEnd);
-            
-                if(SystemClock::GetTimeInSeconds(&diff) >= params->durationInSeconds)
-                    return true;
-            }
-            return false;
-        };
+    if(!GetEgressInterface(&ifIndex , &ifName))
+    {
+        fprintf(stderr, "[UDP CLIENT ~ INFO] : unable to find the egress interface , falling back to userspace pacing.\n");
+        pacingMode = PACING_USER;
+        return;
+    }
 
-        SystemClock::GetSystemTime(&stopTestBegin);
-        while(1)
-        {
-            if(params->stop)
-                return;
+    //The kernel only honors the pacing rate / the launch times when one of these qdiscs sits on the interface
+    bool hasFq  = SocketOptions::HasQdisc(ifIndex , "fq");
+    bool hasEtf = SocketOptions::HasQdisc(ifIndex , "etf");
 
-            uint64_t sleepTime;
-            uint64_t nano;
-            
-            SystemClock::GetSystemTime(&bandwidthTimeBegin);
-            for(uint64_t packet = 0; packet < numberOfPacketsToSend; packet++)
-            {
-                if(CheckTime())
-                    return;
-                UDPSend(params->udpPacketSize);
-            }
+    txTimeUsesTai = (!hasFq && hasEtf);
 
-            if(remainingBytesToSend)
-                UDPSend(remainingBytesToSend);
-            SystemClock::GetSystemTime(&bandwidthTimeEnd);
+    if((pacingMode == PACING_RATE && !hasFq) || (pacingMode == PACING_TXTIME && !hasFq && !hasEtf))
+    {
+        fprintf(stderr, "[UDP CLIENT ~ INFO] : no %s qdisc on %s , falling back to userspace pacing.\n",
+                        (pacingMode == PACING_RATE) ? "fq" : "fq/etf", ifName.c_str());
+        pacingMode = PACING_USER;
+    }
+}
 
-            diff      = SystemClock::GetElapsedTime(&bandwidthTimeBegin , &bandwidthTimeEnd);
-            nano      = SystemClock::GetTimeInNanoSeconds(&diff); 
-            sleepTime = ONE_SECOND_TO_NANO - nano;
+void Client::CreateSenderWorkers()
+{
+    //A fixed pool of threads , every one of them paces its share of the streams
+    uint32_t numberOfWorkers = numberOfSenderThreads;
 
-            if(sleepTime > 0)
-                std::this_thread::sleep_for(std::chrono::nanoseconds(sleepTime));
-        }
-    };
-    
+    if(!numberOfWorkers)
+        numberOfWorkers = std::max<uint32_t>(std::thread::hardware_concurrency() , 1);
+
+    numberOfWorkers = std::min<uint32_t>(numberOfWorkers , std::max<size_t>(serverOpenPorts.size() , 1));
+
+    for(uint32_t worker = 0; worker < numberOfWorkers; worker++)
+        senderWorkers.push_back(new SenderWorker(durationInSeconds , useHugePages , useIoUring , &profile));
+}
+
+void Client::CreateStream(uint16_t serverOpenPort)
+{
     ClientStreamParams* params = CreateUdpClient(serverOpenPort);
-    
-    openStreams.push_back(new std::thread(senderHandler , params));
+
+    //Round robin , the streams share the same rate so every worker gets the same load
+    senderWorkers[(totalParams.size() - 1) % senderWorkers.size()]->AddStream(params);
 }
 
 // ======================================================================================================================================= 
@@ -308,14 +461,21 @@ void Client::TCPSend(NerfPacket& packet)
     sendBytes = send(socketTcpId , tcpbuffer , NERF_PACKET_IN_BYTES , 0);
 }
 
-void Client::TCPRecv()
+uint8_t Client::TCPRecv()
 {
     int64_t recvLen;
 
-    recvLen = recv(socketTcpId, tcpbuffer, NERF_PACKET_IN_BYTES, 0);
+    //The server may send several packets back to back (the phase measurements)
+    recvLen = recv(socketTcpId, tcpbuffer, NERF_PACKET_IN_BYTES, MSG_WAITALL);
+
+    //The server closed the connection , the buffer still holds the packet before
+    if(recvLen < (int64_t)NERF_PACKET_IN_BYTES)
+        return ERROR;
 
     NerfPacket packet = NerfPacket::Deserialize(tcpbuffer);
     ParsePacket(packet);
+
+    return packet.flags;
 }
 
 void Client::ParsePacket(NerfPacket& packet)
@@ -327,10 +487,15 @@ void Client::ParsePacket(NerfPacket& packet)
         memcpy(&isOneWay, packet.payload, sizeof(uint8_t));
         if(isOneWay)
         {
-            double oneWayDelay;
-            memcpy(&oneWayDelay, packet.payload + sizeof(uint8_t), sizeof(double));
+            LatencySummary oneWayDelay;
+            double         clockError;
+            double         clockSkew;
 
-            PrintResults(oneWayDelay);
+            memcpy(&oneWayDelay, packet.payload + sizeof(uint8_t), sizeof(LatencySummary));
+            memcpy(&clockError, packet.payload + sizeof(uint8_t) + sizeof(LatencySummary), sizeof(double));
+            memcpy(&clockSkew, packet.payload + sizeof(uint8_t) + sizeof(LatencySummary) + sizeof(double), sizeof(double));
+
+            PrintResults(oneWayDelay , clockError , clockSkew);
             return;
         }
 
@@ -339,26 +504,62 @@ void Client::ParsePacket(NerfPacket& packet)
         double  jitter;
         double  jitterDeviation;
         double  packetLost;
+        double  localLoss;
 
         memcpy(&averageThroughput ,packet.payload + sizeof(uint8_t)                         ,sizeof(double));
         memcpy(&averageGoodput    ,packet.payload + sizeof(uint8_t) + sizeof(double)        ,sizeof(double));
         memcpy(&packetLost        ,packet.payload + sizeof(uint8_t) + (2 * sizeof(double))  ,sizeof(double));
         memcpy(&jitter            ,packet.payload + sizeof(uint8_t) + (3 * sizeof(double))  ,sizeof(double));
         memcpy(&jitterDeviation   ,packet.payload + sizeof(uint8_t) + (4 * sizeof(double))  ,sizeof(double));
+        memcpy(&localLoss         ,packet.payload + sizeof(uint8_t) + (5 * sizeof(double))  ,sizeof(double));
+
+        //A trial of the search only keeps what decides the next rate
+        if(searching)
+        {
+            trialResults.throughtput = averageThroughput;
+            trialResults.packetLost  = packetLost;
+            trialResults.jitter      = jitter;
+            return;
+        }
+
+        PrintResults(averageThroughput, averageGoodput, packetLost , jitter , jitterDeviation , localLoss);
+    }
+    else if(packet.flags == PHASE_MEASUREMENT)
+    {
+        ClientPhaseResults results;
+
+        memcpy(&results.phase           ,packet.payload                                         ,sizeof(uint16_t));
+        memcpy(&results.throughtput     ,packet.payload + sizeof(uint16_t)                      ,sizeof(double));
+        memcpy(&results.goodput         ,packet.payload + sizeof(uint16_t) + sizeof(double)     ,sizeof(double));
+        memcpy(&results.packetLost      ,packet.payload + sizeof(uint16_t) + (2 * sizeof(double)) ,sizeof(double));
+        memcpy(&results.jitter          ,packet.payload + sizeof(uint16_t) + (3 * sizeof(double)) ,sizeof(double));
+        memcpy(&results.jitterDeviation ,packet.payload + sizeof(uint16_t) + (4 * sizeof(double)) ,sizeof(double));
 
-        PrintResults(averageThroughput, averageGoodput, packetLost , jitter , jitterDeviation);
+        //Printed after the totals , they come just before them
+        phaseResults.push_back(results);
+    }
+    else if(packet.flags == CLOCK)
+    {
+        uint64_t serverSend;
+        uint64_t clientRecv = Pacer::Now();
+
+        //Back right away , the server reads the send times of the datagrams on its clock with it
+        memcpy(&serverSend, packet.payload, sizeof(uint64_t));
+
+        NerfPacket answer = NerfPacket::MakeClockPacket(serverSend , clientRecv , Pacer::Now());
+
+        TCPSend(answer);
     }
     else if(packet.flags == OPEN_PORTS)
     {
         uint32_t numberOfPorts;
+        uint16_t firstPort;
 
+        //The server opens consecutive ports , so only the range is sent (a list would not fit thousands of streams)
         memcpy(&numberOfPorts, packet.payload, sizeof(uint32_t));
+        memcpy(&firstPort, packet.payload + sizeof(uint32_t), sizeof(uint16_t));
         for(uint32_t ports = 0; ports < numberOfPorts; ports++)
-        {
-            uint16_t port;
-            memcpy(&port, packet.payload + sizeof(uint32_t) + (ports * sizeof(uint16_t)), sizeof(uint16_t));
-            serverOpenPorts.push_back(port);
-        }
+            serverOpenPorts.push_back(firstPort + ports);
     }
 }
  
@@ -379,27 +580,62 @@ void Client::SendLastPacketSingal()
 
 void Client::SendTerminateSignal()
 {
+    //Already closed (or in between two trials of the search)
+    if(stopRunning)
+        return;
+
     //Notify the parallel streams to STOP
     stopRunning = true;
 
-    for(auto params : totalParams)
-        params->stop = true;
+    for(auto worker : senderWorkers)
+        worker->Stop();
 
     NerfPacket cancel = NerfPacket::MakeClosePacket();
 
     SendLastPacketSingal();        
 
+    //How long the phases actually lasted , the test may have been stopped early
+    if(!profile.IsEmpty() && streamsStartTime)
+        SendProfile(Pacer::Now() - streamsStartTime);
+
     //inform the server that we are going to close the connection.
     //Now the server must responce with an "measurements" packet. 
     TCPSend(cancel);
 
-    //wait until we get the measurements from the server
-    TCPRecv();
+    //wait until we get the measurements from the server (the ones of the phases come first)
+    uint8_t flags;
+
+    while((flags = TCPRecv()) == PHASE_MEASUREMENT || flags == CLOCK);
+}
+
+void Client::SendProfile(uint64_t duration)
+{
+    std::vector<ProfilePhase>& phases = profile.GetPhases();
+
+    for(uint32_t phase = 0; phase < phases.size(); phase++)
+    {
+        NerfPacket packet = NerfPacket::MakePhasePacket(phase , phases[phase].startNano , profile.GetPhaseDuration(phase , duration) , phases[phase].Describe());
+
+        TCPSend(packet);
+    }
+}
+
+void Client::SendSetup()
+{
+    //The phases of the profile go first , with how long each lasts in this test
+    if(!profile.IsEmpty())
+        SendProfile((uint64_t)(durationInSeconds * ONE_SECOND_TO_NANO));
+
+    //Send the "setup" parameters to the server
+    NerfPacket setupPacket = NerfPacket::MakeSetupPacket(udpPacketSize,numberOfParallelStreams,measureOneWay,printResultsInterval,printResultInter);
+    TCPSend(setupPacket);
+    //Wait to recv the open ports that the client create (a -d test syncs the clocks first)
+    while(TCPRecv() == CLOCK);
 }
 
 void Client::SendStartSignal()
 {
-    NerfPacket start = NerfPacket::MakeStartPacket();
+    NerfPacket start = NerfPacket::MakeStartPacket(streamsStartTime);
 
     //We send the start packet to inforf the server that NOW will start sending UDP data.
     TCPSend(start);
@@ -410,16 +646,63 @@ void Client::SendStartSignal()
 // ======================================================================================================================================= 
 
 void Client::Run()
+{
+    if(searching)
+    {
+        RunSearch();
+        return;
+    }
+
+    SendSetup();
+
+    RunStreams();
+}
+
+void Client::RunStreams()
 {  
+    CheckKernelPacing();
+
+    //"nic" places the threads on the node of the interface that reaches the server
+    if(affinity.UsesNic())
+    {
+        std::string ifName;
+        int ifIndex;
+
+        if(GetEgressInterface(&ifIndex , &ifName))
+            affinity.Resolve(ifName);
+        else
+            fprintf(stderr, "[UDP CLIENT ~ INFO] : unable to find the egress interface , the \"nic\" threads are not pinned.\n");
+    }
+
+    CreateSenderWorkers();
+
     for(auto port : serverOpenPorts)
         CreateStream(port);
 
+    //Every worker (and the profile) starts from the same instant
+    streamsStartTime = Pacer::Now();
+
+    //A worker is pinned before it allocates its buffers , so they land on its node
+    for(uint32_t index = 0; index < senderWorkers.size(); index++)
+    {
+        auto workerHandler = [this](uint32_t index)
+        {
+            affinity.PinStream(index);
+
+            senderWorkers[index]->Run(streamsStartTime);
+        };
+
+        openStreams.push_back(new std::thread(workerHandler , index));
+    }
+
     auto tcpHandle = [this]()
     {    
         Time stopTestBegin;
         Time stopTestEnd;
         Time diff;
 
+        affinity.PinControl();
+
         SendStartSignal();
 
         SystemClock::GetSystemTime(&stopTestBegin);
@@ -467,7 +750,11 @@ void Client::Run()
 
     if(testAccordingToTime && !stopRunning)
     {
-        fprintf(stdout , "\nStop sending data.\nWaiting for the final results...\n\n");
+        //The datagrams still in flight (or queued at the server) are not lost
+        if(searching)
+            std::this_thread::sleep_for(std::chrono::nanoseconds(SEARCH_SETTLE_NANO));
+        else
+            fprintf(stdout , "\nStop sending data.\nWaiting for the final results...\n\n");
         
         SendTerminateSignal();
     }
@@ -475,6 +762,89 @@ void Client::Run()
     return;
 }
 
+bool Client::RunTrial(uint64_t _bandwidth , ClientTrialResults* results)
+{
+    if(searchStopped)
+        return false;
+
+    bandwidth = _bandwidth;
+    memset(&trialResults , 0 , sizeof(ClientTrialResults));
+
+    //The same connection for every trial , the server opens new ports for each one
+    SendSetup();
+
+    stopRunning = false;
+
+    RunStreams();
+
+    CleanUpStreams();
+
+    *results           = trialResults;
+    results->bandwidth = _bandwidth;
+
+    //An interrupted trial says nothing about its rate
+    return !searchStopped;
+}
+
+void Client::RunSearch()
+{
+    uint64_t maxBandwidth = bandwidth;
+
+    if(searchPacketSizes.empty())
+        searchPacketSizes.push_back(udpPacketSize);
+
+    fprintf(resultsFile, "\nThroughput Search  :: up to %0.3lfMbits/s , at most %0.2lf%% lost , %0.2lfs trials\n",
+                          (maxBandwidth * numberOfParallelStreams) / 1000000.0, searchLossThreshold, durationInSeconds);
+
+    for(auto packetSize : searchPacketSizes)
+    {
+        ClientTrialResults results;
+        ClientTrialResults best;
+
+        uint64_t low    = 0;
+        uint64_t high   = maxBandwidth;
+        uint64_t rate   = maxBandwidth;
+        uint32_t trials = 0;
+
+        memset(&best , 0 , sizeof(ClientTrialResults));
+
+        udpPacketSize = packetSize;
+
+        //RFC 2544 : the first trial at the maximum rate , then halve the range that holds the highest rate that passes
+        while(trials < SEARCH_MAX_TRIALS)
+        {
+            //Stopped , what the finished trials found still holds
+            if(!RunTrial(rate , &results))
+            {
+                if(trials)
+                    PrintSearchResults(&best , trials);
+                return;
+            }
+
+            trials++;
+
+            bool passed = (results.packetLost <= searchLossThreshold);
+
+            PrintTrial(&results , passed);
+
+            if(passed)
+            {
+                best = results;
+                low  = rate;
+            }
+            else
+                high = rate;
+
+            if((high - low) <= (high * SEARCH_RESOLUTION) || high < 2)
+                break;
+
+            rate = low + ((high - low) / 2);
+        }
+
+        PrintSearchResults(&best , trials);
+    }
+}
+
 // ======================================================================================================================================= 
 // ==================================================== Print Functions ==================================================================
 // =======================================================================================================================================
@@ -484,27 +854,147 @@ void Client::PrintResults(double throughtput,
                           double goodput,
                           double packetLost, 
                           double jitter, 
-                          double jitterDeviation)
+                          double jitterDeviation,
+                          double localLoss)
 {
     uint64_t totalPacketsSend = 0;
     int64_t  totalBytesSend   = 0;
+    uint64_t totalSyscalls    = 0;
+    double   packetsPerSecond = 0.0f;
+    double   bitsPerSecond    = 0.0f;
+    double   cpuTime          = 0.0f;
+    uint64_t completions      = 0;
+    uint64_t copied           = 0;
+
+    PacingStatistics pacing;
 
     for(auto params : totalParams)
     {
+        Time diff = SystemClock::GetElapsedTime(&params->startTime , &params->endTime);
+        double sendDuration = SystemClock::GetTimeInSeconds(&diff);
+
         totalPacketsSend += params->udpSeqNumber;
         totalBytesSend   += params->totalBytesSend;
+        totalSyscalls    += params->totalSyscalls;
+
+        //The streams run in parallel so their rates add up
+        if(sendDuration > 0)
+        {
+            packetsPerSecond += params->udpSeqNumber / sendDuration;
+            bitsPerSecond    += (params->totalBytesSend * 8) / sendDuration;
+        }
+
+        PacingStatistics::CombineStatistics(&pacing , &params->pacer.statistics);
+
+        if(params->zeroCopy)
+        {
+            completions += params->zeroCopy->completions;
+            copied      += params->zeroCopy->copied;
+        }
+    }
+
+    for(auto worker : senderWorkers)
+    {
+        cpuTime       += worker->cpuTime;
+        totalSyscalls += worker->totalSyscalls;
     }
 
     fprintf(resultsFile, "\nTotal Bytes Send   :: %ld Bytes\n",     totalBytesSend);
     fprintf(resultsFile, "Total Packets Send :: %ld\n",             totalPacketsSend);
+    fprintf(resultsFile, "Send Syscalls      :: %ld\n",             totalSyscalls);
+    fprintf(resultsFile, "Syscalls Saved     :: %ld\n",             (totalPacketsSend > totalSyscalls) ? (totalPacketsSend - totalSyscalls) : 0);
+    fprintf(resultsFile, "Packets Rate       :: %0.0lfpps\n",        packetsPerSecond);
+    if(!totalParams.empty())
+    {
+        //A profile averages its phases over the time the streams ran
+        double expectedBandwidth = bandwidth;
+
+        if(!profile.IsEmpty())
+        {
+            Time diff = SystemClock::GetElapsedTime(&totalParams[0]->startTime , &totalParams[0]->endTime);
+
+            expectedBandwidth = profile.GetMeanBandwidth(SystemClock::GetTimeInNanoSeconds(&diff));
+        }
+
+        if(expectedBandwidth > 0)
+            fprintf(resultsFile, "Rate Error         :: %0.3lf%%\n", 100.0 * ((bitsPerSecond / (expectedBandwidth * totalParams.size())) - 1.0));
+    }
+    if(pacingMode == PACING_USER)
+        fprintf(resultsFile, "Pacing Error       :: mean %0.2lfus , deviation %0.2lfus , max %0.2lfus\n", 
+                              pacing.GetMeanError(), pacing.GetErrorDeviation(), pacing.GetMaxError());
+    else
+        fprintf(resultsFile, "Pacing             :: kernel (%s)\n", (pacingMode == PACING_RATE) ? "SO_MAX_PACING_RATE" : "SO_TXTIME");
+    //The CPU time is known once the streams are done
+    if(cpuTime > 0 && totalBytesSend > 0)
+        fprintf(resultsFile, "CPU Cost           :: %0.3lfms/Gbit (%s)\n", (cpuTime * 1000.0) / ((totalBytesSend * 8) / 1000000000.0), useZeroCopy ? "zerocopy" : "copy");
+    if(useZeroCopy)
+        fprintf(resultsFile, "Zerocopy           :: %ld completions , %ld copied by the kernel\n", completions, copied);
     fprintf(resultsFile, "Throughtput        :: %0.3lfMbits/s\n",   throughtput);
     fprintf(resultsFile, "Goodput            :: %0.3lfMbits/s\n",   goodput);
     fprintf(resultsFile, "Packet Lost        :: %0.2lf%%\n",        packetLost);
+    fprintf(resultsFile, "   Network         :: %0.2lf%%\n",        std::max(packetLost - localLoss , 0.0));
+    fprintf(resultsFile, "   Local Receiver  :: %0.2lf%%\n",        localLoss);
     fprintf(resultsFile, "Jitter             :: %0.2lfms\n",        jitter);
     fprintf(resultsFile, "Jitter Deviation   :: %0.6lf\n",          jitterDeviation);
+
+    PrintPhaseResults();
+}
+
+void Client::PrintResults(const LatencySummary& oneWayDelay , double clockError , double clockSkew)
+{
+    fprintf(resultsFile, "One Way Delay      :: min %0.3lfms , mean %0.3lfms , max %0.3lfms\n",
+                          oneWayDelay.min, oneWayDelay.mean, oneWayDelay.max);
+    fprintf(resultsFile, "   Percentiles     :: p50 %0.3lfms , p90 %0.3lfms , p99 %0.3lfms , p99.9 %0.3lfms\n",
+                          oneWayDelay.p50, oneWayDelay.p90, oneWayDelay.p99, oneWayDelay.p999);
+    fprintf(resultsFile, "   Clock Error     :: +/- %0.3lfms\n", clockError);
+
+    //A test too short to estimate it
+    if(clockSkew != 0.0)
+        fprintf(resultsFile, "   Clock Skew      :: %0.3lfppm\n", clockSkew);
 }
 
-void Client::PrintResults(double oneWayDelay)
+void Client::PrintPhaseResults()
 {
-    fprintf(resultsFile, "One Way Delay  :: %0.2lfms\n", oneWayDelay);
+    std::vector<ProfilePhase>& phases = profile.GetPhases();
+
+    for(auto results : phaseResults)
+    {
+        if(results.phase >= phases.size())
+            continue;
+
+        fprintf(resultsFile, "\nPhase %-11u :: %s\n",               results.phase + 1, phases[results.phase].Describe().c_str());
+        fprintf(resultsFile, "Throughtput        :: %0.3lfMbits/s\n", results.throughtput);
+        fprintf(resultsFile, "Goodput            :: %0.3lfMbits/s\n", results.goodput);
+        fprintf(resultsFile, "Packet Lost        :: %0.2lf%%\n",      results.packetLost);
+        fprintf(resultsFile, "Jitter             :: %0.2lfms\n",      results.jitter);
+        fprintf(resultsFile, "Jitter Deviation   :: %0.6lf\n",        results.jitterDeviation);
+    }
+
+    phaseResults.clear();
+}
+
+void Client::PrintTrial(ClientTrialResults* results , bool passed)
+{
+    fprintf(resultsFile, "Trial              :: %u bytes at %0.3lfMbits/s , received %0.3lfMbits/s , lost %0.2lf%% (%s)\n",
+                          udpPacketSize, (results->bandwidth * numberOfParallelStreams) / 1000000.0, results->throughtput, results->packetLost,
+                          passed ? "pass" : "fail");
+}
+
+void Client::PrintSearchResults(ClientTrialResults* best , uint32_t trials)
+{
+    fprintf(resultsFile, "\nPacket Size        :: %u bytes\n", udpPacketSize);
+    fprintf(resultsFile, "Trials             :: %u\n",       trials);
+
+    if(!best->bandwidth)
+    {
+        fprintf(resultsFile, "Max Rate           :: every trial lost more than %0.2lf%%\n\n", searchLossThreshold);
+        return;
+    }
+
+    double offered = (double)best->bandwidth * numberOfParallelStreams;
+
+    fprintf(resultsFile, "Max Rate           :: %0.3lfMbits/s (%0.0lfpps)\n", offered / 1000000.0, offered / (udpPacketSize * 8));
+    fprintf(resultsFile, "Throughtput        :: %0.3lfMbits/s\n", best->throughtput);
+    fprintf(resultsFile, "Packet Lost        :: %0.2lf%%\n",      best->packetLost);
+    fprintf(resultsFile, "Jitter             :: %0.2lfms\n\n",   best->jitter);
 }
\ No newline at end of file
@@ -3,25 +3,37 @@
 
 #include "Utilities.h"
 #include "NerfPacket.h"
+#include "SenderWorker.h"
+#include "Affinity.h"
+
+#include <atomic>
 
 #define DEFAULT_SERVER_PORT_TO_SEND    3742
 #define DEFAULT_SERVER_IP_TO_SEND      "127.0.0.1"  
 
-struct ClientStreamParams
-{
-    int socketId;
-    uint16_t port;
-    struct sockaddr_in serverToSendData;
-
-    int64_t  totalBytesSend;
+#define SEARCH_DEFAULT_TRIAL           1.0     // seconds , how long a trial of the throughput search sends
+#define SEARCH_RESOLUTION              0.01    // stop once the highest lossless rate is known within 1%
+#define SEARCH_MAX_TRIALS              20      // per packet size
+#define SEARCH_SETTLE_NANO             100000000 // 100ms , late datagrams still count for the trial
 
-    uint64_t udpSeqNumber;
+//What the server measured in a phase of the traffic profile
+struct ClientPhaseResults
+{
+    uint16_t phase;
+    double   throughtput;
+    double   goodput;
+    double   packetLost;
+    double   jitter;
+    double   jitterDeviation;
+};
 
-    uint32_t udpPacketSize;
+//A trial of the throughput search , the rate is per stream
+struct ClientTrialResults
+{
     uint64_t bandwidth;
-    uint64_t durationInSeconds;
-
-    bool stop;
+    double   throughtput;
+    double   packetLost;
+    double   jitter;
 };
 
 class Client
@@ -29,12 +41,36 @@ class Client
 private: 
     //Internal variables
     uint32_t udpPacketSize;
+    uint32_t batchSize;
+    uint32_t burstSize;
+    uint8_t  pacingMode;
+    bool     txTimeUsesTai;
+    uint8_t  useGso;
+    uint8_t  useZeroCopy;
+    uint8_t  useHugePages;
+    uint8_t  useIoUring;
+    uint32_t socketBufferCap;
+    uint32_t numberOfSenderThreads;
+    Affinity affinity;
     uint16_t numberOfParallelStreams;
     uint8_t  measureOneWay;
     uint64_t bandwidth;
     uint8_t  testAccordingToTime;
     double   durationInSeconds;
     double   printResultsInterval;
+    uint8_t  printResultInter;
+
+    //Traffic profile , the streams start (and its phases are relative to) "streamsStartTime"
+    TrafficProfile profile;
+    uint64_t       streamsStartTime;
+    std::vector<ClientPhaseResults> phaseResults;
+
+    //Throughput search (RFC 2544) , every packet size gets its own binary search over the same connection
+    bool     searching;
+    std::atomic<bool> searchStopped;
+    double   searchLossThreshold;
+    std::vector<uint32_t> searchPacketSizes;
+    ClientTrialResults    trialResults;
 
     //Server ip/port
     uint16_t serverPort;
@@ -56,14 +92,15 @@ private:
 
     FILE* resultsFile;
     
-    //State
-    bool stopRunning = false;
+    //State , a stop may come from the SIGINT handler
+    std::atomic<bool> stopRunning{false};
 
     //Client socket/port inforamtions
     std::vector<uint16_t> serverOpenPorts;
     std::vector<int> openSockets;
     std::vector<struct sockaddr_in> addressedToSendData;
     std::vector<ClientStreamParams*> totalParams;
+    std::vector<SenderWorker*> senderWorkers;
     std::vector<std::thread*> openStreams;
 
 public:
@@ -98,8 +135,39 @@ public:
                       double _printResultsInterval,
                       uint8_t _printResultInter);
 
+    void SetBatchSize(uint32_t _batchSize);
+
+    void SetBurstSize(uint32_t _burstSize);
+
+    void SetPacingMode(uint8_t _pacingMode);
+
+    void SetGso(uint8_t _useGso);
+
+    void SetZeroCopy(uint8_t _useZeroCopy);
+
+    void SetHugePages(uint8_t _useHugePages);
+
+    void SetIoUring(uint8_t _useIoUring);
+
+    void SetSocketBufferCap(uint32_t _socketBufferCap);
+
+    void SetSenderThreads(uint32_t _numberOfSenderThreads);
+
+    void SetProfile(const TrafficProfile& _profile);
+
+    void SetAffinity(const Affinity& _affinity);
+
+    //Search the highest rate (up to the bandwidth) that loses at most "_lossThreshold" percent ,
+    //for every packet size (just the one of the test if none)
+    void SetSearch(double _lossThreshold , std::vector<uint32_t> _packetSizes);
+
+    void StopSearch();
+
     void CleanUp();
 
+    //The sockets , streams and workers of a single test
+    void CleanUpStreams();
+
     // ======================================================================================================================================= 
     // ================================================== Create Functions =================================================================== 
     // ======================================================================================================================================= 
@@ -108,6 +176,13 @@ public:
    
     ClientStreamParams* CreateUdpClient(uint16_t serverOpenPort);
 
+    //The interface (and its index) that the kernel routes the datagrams to the server through
+    bool GetEgressInterface(int* ifIndex , std::string* ifName);
+
+    void CheckKernelPacing();
+
+    void CreateSenderWorkers();
+
     void CreateStream(uint16_t serverOpenPort);
 
     // ======================================================================================================================================= 
@@ -116,7 +191,7 @@ public:
 
     void TCPSend(NerfPacket& packet);
 
-    void TCPRecv();
+    uint8_t TCPRecv();
     
     void ParsePacket(NerfPacket& packet);
 
@@ -130,12 +205,24 @@ public:
     
     void SendStartSignal();
 
+    void SendProfile(uint64_t duration);
+
+    //The phases (if any) and the SETUP , returns once the server opened its ports
+    void SendSetup();
+
     // ======================================================================================================================================= 
     // ======================================================= Run =========================================================================== 
     // ======================================================================================================================================= 
     
     void Run();
 
+    void RunStreams();
+
+    //A test of "durationInSeconds" at "_bandwidth" per stream , false if the search was stopped
+    bool RunTrial(uint64_t _bandwidth , ClientTrialResults* results);
+
+    void RunSearch();
+
     // ======================================================================================================================================= 
     // ==================================================== Print FUnctions ==================================================================
     // =======================================================================================================================================
@@ -144,9 +231,16 @@ public:
                       double goodput,
                       double packetLost, 
                       double jitter, 
-                      double jitterDeviation);
+                      double jitterDeviation,
+                      double localLoss);
+
+    void PrintResults(const LatencySummary& oneWayDelay , double clockError , double clockSkew);
+
+    void PrintPhaseResults();
+
+    void PrintTrial(ClientTrialResults* results , bool passed);
 
-    void PrintResults(double oneWayDelay);
+    void PrintSearchResults(ClientTrialResults* best , uint32_t trials);
 };
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include "ClockSync.h"
+
+ClockSync::ClockSync()
+{
+    Reset();
+}
+
+void ClockSync::Reset()
+{
+    memset(samples , 0 , sizeof(samples));
+    numberOfSamples = 0;
+    skew            = 0.0f;
+
+    error.store(0 , std::memory_order_relaxed);
+
+    Publish();
+}
+
+void ClockSync::Push(uint64_t serverSend , uint64_t clientRecv , uint64_t clientSend , uint64_t serverRecv)
+{
+    ClockSample* sample = &samples[numberOfSamples % CLOCK_SYNC_WINDOW];
+    int64_t      held   = (int64_t)clientSend - (int64_t)clientRecv;
+    int64_t      rtt    = ((int64_t)serverRecv - (int64_t)serverSend) - held;
+
+    sample->offset = (((int64_t)clientRecv - (int64_t)serverSend) + ((int64_t)clientSend - (int64_t)serverRecv)) / 2;
+    sample->rtt    = std::max<int64_t>(rtt , 0);
+    sample->time   = serverSend + ((serverRecv - serverSend) / 2);
+
+    numberOfSamples++;
+
+    Publish();
+}
+
+void ClockSync::SetSkew(double _skew)
+{
+    skew = _skew;
+
+    Publish();
+}
+
+void ClockSync::Publish()
+{
+    ClockModel next = {0 , 0 , skew};
+
+    if(numberOfSamples)
+    {
+        //The fastest exchange of the window , the older ones do not follow the drift of the clocks anymore
+        ClockSample* fastest = &samples[0];
+
+        for(uint32_t index = 1; index < std::min<uint32_t>(numberOfSamples , CLOCK_SYNC_WINDOW); index++)
+            if(samples[index].rtt < fastest->rtt)
+                fastest = &samples[index];
+
+        next.offset = fastest->offset;
+        next.time   = fastest->time;
+
+        error.store(fastest->rtt / 2 , std::memory_order_relaxed);
+    }
+
+    model.Write(next);
+}
+
+int64_t ClockSync::GetOffset(uint64_t timeNano) const
+{
+    ClockModel current;
+
+    model.Read(&current);
+
+    if(!current.time)
+        return current.offset;
+
+    return current.offset + (int64_t)(current.skew * ((int64_t)timeNano - (int64_t)current.time));
+}
@@ -0,0 +1,82 @@
+#ifndef _CLOCK_SYNC_H_
+#define _CLOCK_SYNC_H_
+
+#include "Utilities.h"
+#include "SeqLock.h"
+
+#include <atomic>
+
+#define CLOCK_SYNC_SAMPLES          8          // exchanges before the streams of a -d test open
+#define CLOCK_SYNC_INTERVAL_NANO    1000000000 // 1s , one more exchange during the test
+#define CLOCK_SYNC_WINDOW           16         // the estimate comes from the fastest of the last exchanges
+
+//An exchange over the control connection , the 4 timestamps of NTP
+struct ClockSample
+{
+    int64_t  offset;   // client clock - server clock
+    uint64_t rtt;      // without the time that the client held the probe
+    uint64_t time;     // server clock , the middle of the exchange
+};
+
+//The offset at "time" , and how fast it drifts from there (the skew , ns per ns)
+struct ClockModel
+{
+    int64_t  offset;
+    uint64_t time;
+    double   skew;
+};
+
+//The offset of the clock of the client (its CLOCK_MONOTONIC) from the one of the server , so the send times of the
+//datagrams can be read on the clock of the server. The queues delay the exchanges , never speed them up , so the
+//fastest one of the recent ones (the minimum RTT filter) is the closest to the truth : its offset is off by at most
+//half of its round trip.
+//
+//Once the skew is known (SkewEstimator) the offset drifts with it from the time of that exchange , so the offset
+//of the datagrams follows the drift between two exchanges.
+//
+//The TCP thread pushes , the receivers read the offset of every datagram.
+class ClockSync
+{
+private:
+    ClockSample samples[CLOCK_SYNC_WINDOW];
+    uint32_t    numberOfSamples;
+    double      skew;
+
+    SeqLock<ClockModel>   model;
+    std::atomic<uint64_t> error;
+
+    void Publish();
+
+public:
+    ClockSync();
+
+    void Reset();
+
+    //"serverSend" and "serverRecv" on the clock of the server , "clientRecv" and "clientSend" on the one of the client
+    void Push(uint64_t serverSend , uint64_t clientRecv , uint64_t clientSend , uint64_t serverRecv);
+
+    //The TCP thread , the offset drifts at "_skew" ns per ns
+    void SetSkew(double _skew);
+
+    //What turns a time of the client into one of the server (subtracted) at "timeNano" (server clock) ,
+    //0 before the first exchange
+    int64_t GetOffset(uint64_t timeNano) const;
+
+    //How far (ns) the offset may be from the truth
+    inline uint64_t GetError() const
+    {
+        return error.load(std::memory_order_relaxed);
+    }
+
+    inline uint32_t GetSamples() const
+    {
+        return numberOfSamples;
+    }
+
+    inline double GetSkew() const
+    {
+        return skew;
+    }
+};
+
+#endif
@@ -0,0 +1,229 @@
+#include "EventLoop.h"
+
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+EventLoop::EventLoop()
+{
+    epollId  = -1;
+    stopId   = -1;
+    stopped  = false;
+    spinNano = 0;
+    woken    = false;
+
+    totalSyscalls = 0;
+    totalSleeps   = 0;
+}
+
+EventLoop::~EventLoop()
+{
+    Release();
+}
+
+bool EventLoop::Setup()
+{
+    struct epoll_event event;
+
+    if( (epollId = epoll_create1(EPOLL_CLOEXEC)) < 0 )
+        return false;
+
+    if( (stopId = eventfd(0 , EFD_NONBLOCK | EFD_CLOEXEC)) < 0 )
+    {
+        Release();
+        return false;
+    }
+
+    //The only source without a handler
+    memset(&event , 0 , sizeof(struct epoll_event));
+    event.events   = EPOLLIN;
+    event.data.ptr = NULL;
+
+    if(epoll_ctl(epollId , EPOLL_CTL_ADD , stopId , &event))
+    {
+        Release();
+        return false;
+    }
+
+    stopped = false;
+
+    return true;
+}
+
+void EventLoop::Release()
+{
+    for(auto source : sources)
+    {
+        //The loop owns the timers , the sockets belong to the caller
+        if(source->owned)
+            close(source->fd);
+        delete source;
+    }
+    sources.clear();
+    ready.clear();
+
+    if(stopId >= 0)
+        close(stopId);
+    if(epollId >= 0)
+        close(epollId);
+
+    stopId  = -1;
+    epollId = -1;
+}
+
+bool EventLoop::Add(int fd , uint32_t events , bool owned , EventHandler handler)
+{
+    EventSource*       source = new EventSource;
+    struct epoll_event event;
+
+    source->fd      = fd;
+    source->handler = handler;
+    source->ready   = false;
+    source->owned   = owned;
+
+    memset(&event , 0 , sizeof(struct epoll_event));
+    event.events   = events;
+    event.data.ptr = source;
+
+    if(epoll_ctl(epollId , EPOLL_CTL_ADD , source->fd , &event))
+    {
+        delete source;
+        return false;
+    }
+
+    sources.push_back(source);
+
+    return true;
+}
+
+bool EventLoop::Add(int fd , bool edgeTriggered , EventHandler handler)
+{
+    return Add(fd , edgeTriggered ? (EPOLLIN | EPOLLET) : EPOLLIN , false , handler);
+}
+
+bool EventLoop::AddTimer(uint64_t periodNano , EventHandler handler)
+{
+    struct itimerspec period;
+    int timerId;
+
+    if( (timerId = timerfd_create(CLOCK_MONOTONIC , TFD_NONBLOCK | TFD_CLOEXEC)) < 0 )
+        return false;
+
+    period.it_interval.tv_sec  = periodNano / ONE_SECOND_TO_NANO;
+    period.it_interval.tv_nsec = periodNano % ONE_SECOND_TO_NANO;
+    period.it_value            = period.it_interval;
+
+    if(timerfd_settime(timerId , 0 , &period , NULL))
+    {
+        close(timerId);
+        return false;
+    }
+
+    //The expirations have to be read , or the timer stays readable
+    bool added = Add(timerId , EPOLLIN , true , [timerId , handler]()
+    {
+        uint64_t expirations;
+
+        if(read(timerId , &expirations , sizeof(uint64_t)) == sizeof(uint64_t))
+            handler();
+
+        return true;
+    });
+
+    if(!added)
+        close(timerId);
+
+    return added;
+}
+
+void EventLoop::SetBusyPoll(uint64_t _spinNano)
+{
+    spinNano = _spinNano;
+}
+
+void EventLoop::Run()
+{
+    struct epoll_event events[EVENT_LOOP_MAX_EVENTS];
+    Time     now;
+    uint64_t lastEvent = 0;
+
+    while(!stopped)
+    {
+        //Sleep only once every ready source is drained (and the spin budget is spent)
+        int timeout = ready.empty() ? -1 : 0;
+
+        if(timeout < 0 && spinNano)
+        {
+            SystemClock::GetSystemTime(&now);
+            if(SystemClock::GetTimeInNanoSeconds(&now) - lastEvent < spinNano)
+                timeout = 0;
+        }
+
+        totalSyscalls++;
+        if(timeout < 0)
+            totalSleeps++;
+
+        int numberOfEvents = epoll_wait(epollId , events , EVENT_LOOP_MAX_EVENTS , timeout);
+        if(numberOfEvents < 0)
+        {
+            if(errno == EINTR)
+                continue;
+
+            perror("[NERF ~ INFO] : epoll_wait");
+            return;
+        }
+
+        if(numberOfEvents > 0)
+        {
+            woken = (timeout < 0);
+
+            if(spinNano)
+            {
+                SystemClock::GetSystemTime(&now);
+                lastEvent = SystemClock::GetTimeInNanoSeconds(&now);
+            }
+        }
+
+        for(int event = 0; event < numberOfEvents; event++)
+        {
+            EventSource* source = (EventSource*)events[event].data.ptr;
+
+            if(!source)
+            {
+                stopped = true;
+                break;
+            }
+
+            if(!source->ready)
+            {
+                source->ready = true;
+                ready.push_back(source);
+            }
+        }
+
+        //A pass over the ready sources , whoever is not done yet stays for the next one
+        for(uint32_t index = 0; index < ready.size() && !stopped;)
+        {
+            EventSource* source = ready[index];
+
+            if(source->handler())
+            {
+                source->ready = false;
+                ready[index]  = ready.back();
+                ready.pop_back();
+            }
+            else
+                index++;
+        }
+    }
+}
+
+void EventLoop::Stop()
+{
+    uint64_t value = 1;
+
+    //Async signal safe , it may come from the SIGINT handler
+    if(stopId >= 0 && write(stopId , &value , sizeof(uint64_t)) < 0)
+        perror("[NERF ~ INFO] : unable to stop the event loop");
+}
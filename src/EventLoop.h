@@ -0,0 +1,78 @@
+#ifndef _EVENT_LOOP_H_
+#define _EVENT_LOOP_H_
+
+#include "Utilities.h"
+
+#include <functional>
+
+#define EVENT_LOOP_MAX_EVENTS   64
+
+//Called when its descriptor is readable. An edge triggered descriptor says so only once , so the
+//handler drains it and returns true. False when it stopped early (its budget) , the loop then calls
+//it again after the other ready descriptors , before it sleeps.
+typedef std::function<bool()> EventHandler;
+
+struct EventSource
+{
+    int          fd;
+    EventHandler handler;
+    bool         ready;
+    bool         owned;   // closed with the loop (the timers)
+};
+
+//An epoll loop for a single thread. Stop (from any thread , or a signal handler) wakes it
+//through an eventfd , so it never needs a timeout to notice.
+class EventLoop
+{
+private:
+    int epollId;
+    int stopId;
+
+    std::vector<EventSource*> sources;
+    std::vector<EventSource*> ready;
+
+    //Only the owner thread touches it , the eventfd is what the other threads see
+    bool stopped;
+
+    //Busy polling , how long the loop keeps spinning after the last event before it sleeps (0 , never spins)
+    uint64_t spinNano;
+    bool     woken;
+
+    bool Add(int fd , uint32_t events , bool owned , EventHandler handler);
+
+public:
+    //Every epoll_wait , and the ones that slept
+    uint64_t totalSyscalls;
+    uint64_t totalSleeps;
+
+    EventLoop();
+
+    ~EventLoop();
+
+    bool Setup();
+
+    void Release();
+
+    //"edgeTriggered" descriptors must be non blocking , their handler reads until EAGAIN
+    bool Add(int fd , bool edgeTriggered , EventHandler handler);
+
+    //A periodic timerfd , the handler runs once however many periods were missed
+    bool AddTimer(uint64_t periodNano , EventHandler handler);
+
+    //Polls the descriptors without sleeping for "_spinNano" after the last event , a sleep and its wakeup
+    //cost more than the latency that a datagram is measured with
+    void SetBusyPoll(uint64_t _spinNano);
+
+    //The ready descriptors came with a wakeup from a sleeping wait , not from a spin or a budget pass
+    inline bool Woken()
+    {
+        return woken;
+    }
+
+    //Until Stop
+    void Run();
+
+    void Stop();
+};
+
+#endif
@@ -0,0 +1,184 @@
+#include "IntervalRing.h"
+
+#include <math.h>
+
+// =======================================================================================================================================
+// ================================================== Interval Stats =====================================================================
+// =======================================================================================================================================
+
+void IntervalStats::Reset()
+{
+    memset(this , 0 , sizeof(IntervalStats));
+}
+
+void IntervalStats::Add(const IntervalStats& stats)
+{
+    bytes         += stats.bytes;
+    bytesWll      += stats.bytesWll;
+    packets       += stats.packets;
+    sent          += stats.sent;
+    jitterTotal   += stats.jitterTotal;
+    jitterSquares += stats.jitterSquares;
+
+    for(uint32_t bin = 0; bin < INTERVAL_LATENCY_BINS; bin++)
+        latency[bin] += stats.latency[bin];
+}
+
+double IntervalStats::GetThroughtput(double duration)
+{
+    return (duration > 0.0) ? ((bytesWll * 8) / duration) / 1000000.0 : 0.0;
+}
+
+double IntervalStats::GetGoodput(double duration)
+{
+    return (duration > 0.0) ? ((bytes * 8) / duration) / 1000000.0 : 0.0;
+}
+
+double IntervalStats::GetPacketLostPercentage()
+{
+    //A packet reordered over the edge of the intervals arrives in a later one than it was sent in
+    return (sent > packets) ? (100.0 * (sent - packets)) / sent : 0.0;
+}
+
+double IntervalStats::GetJitter()
+{
+    return packets ? (jitterTotal / packets) * 1000 : 0.0;
+}
+
+double IntervalStats::GetJitterStandardDeviation()
+{
+    if(packets < 2)
+        return 0.0;
+
+    double mean = jitterTotal / packets;
+
+    return sqrt(std::max((jitterSquares / packets) - (mean * mean) , 0.0));
+}
+
+uint64_t IntervalStats::GetLatencyBinStart(uint32_t bin)
+{
+    return bin ? (1ULL << (bin - 1)) : 0;
+}
+
+// =======================================================================================================================================
+// ================================================== Interval Ring ======================================================================
+// =======================================================================================================================================
+
+IntervalRing::IntervalRing()
+{
+    buckets         = NULL;
+    capacity        = 0;
+    bucketNano      = 1;
+    epoch           = 0;
+    currentInterval = 0;
+    current         = NULL;
+}
+
+IntervalRing::~IntervalRing()
+{
+    if(buckets)
+        delete [] buckets;
+}
+
+void IntervalRing::Setup(uint64_t _epoch , uint64_t _bucketNano , uint32_t _capacity)
+{
+    if(buckets)
+        delete [] buckets;
+
+    epoch      = _epoch;
+    bucketNano = std::max<uint64_t>(_bucketNano , 1);
+    capacity   = std::max<uint32_t>(_capacity , 2);
+    buckets    = new Bucket[capacity];
+
+    //Every bucket holds an interval that is not there yet , the readers take it for an empty one
+    for(uint32_t bucket = 0; bucket < capacity; bucket++)
+    {
+        buckets[bucket].interval.store(UINT64_MAX , std::memory_order_relaxed);
+        buckets[bucket].bytes.store(0 , std::memory_order_relaxed);
+        buckets[bucket].bytesWll.store(0 , std::memory_order_relaxed);
+        buckets[bucket].packets.store(0 , std::memory_order_relaxed);
+        buckets[bucket].sent.store(0 , std::memory_order_relaxed);
+        buckets[bucket].jitterTotal.store(0.0 , std::memory_order_relaxed);
+        buckets[bucket].jitterSquares.store(0.0 , std::memory_order_relaxed);
+        for(uint32_t bin = 0; bin < INTERVAL_LATENCY_BINS; bin++)
+            buckets[bucket].latency[bin].store(0 , std::memory_order_relaxed);
+    }
+
+    currentInterval = 0;
+    current         = NULL;
+}
+
+uint64_t IntervalRing::GetInterval(uint64_t timeNano) const
+{
+    return (timeNano > epoch) ? (timeNano - epoch) / bucketNano : 0;
+}
+
+void IntervalRing::Push(uint64_t arrivalNano , uint64_t bytes , uint64_t bytesWll , uint64_t sent , double jitter , uint64_t latencyNano)
+{
+    uint64_t interval = GetInterval(arrivalNano);
+
+    if(!current || interval > currentInterval)
+    {
+        current         = &buckets[interval % capacity];
+        currentInterval = interval;
+
+        //Marked before the counters of the old interval go , a reader that saw the old one then sees it changed
+        current->interval.store(UINT64_MAX - 1 , std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        current->bytes.store(0 , std::memory_order_relaxed);
+        current->bytesWll.store(0 , std::memory_order_relaxed);
+        current->packets.store(0 , std::memory_order_relaxed);
+        current->sent.store(0 , std::memory_order_relaxed);
+        current->jitterTotal.store(0.0 , std::memory_order_relaxed);
+        current->jitterSquares.store(0.0 , std::memory_order_relaxed);
+        for(uint32_t bin = 0; bin < INTERVAL_LATENCY_BINS; bin++)
+            current->latency[bin].store(0 , std::memory_order_relaxed);
+
+        current->interval.store(interval , std::memory_order_release);
+    }
+
+    //Under 1us , then a bin per power of two
+    uint64_t latencyMicro = latencyNano / 1000;
+    uint32_t bin          = latencyMicro ? std::min<uint32_t>(64 - __builtin_clzll(latencyMicro) , INTERVAL_LATENCY_BINS - 1) : 0;
+
+    Add<uint64_t>(current->bytes , bytes);
+    Add<uint64_t>(current->bytesWll , bytesWll);
+    Add<uint64_t>(current->packets , 1);
+    Add<uint64_t>(current->sent , sent);
+    Add<double>(current->jitterTotal , jitter);
+    Add<double>(current->jitterSquares , jitter * jitter);
+    Add<uint32_t>(current->latency[bin] , 1);
+}
+
+bool IntervalRing::Get(uint64_t interval , IntervalStats* stats) const
+{
+    if(!buckets)
+        return true;
+
+    const Bucket* bucket = &buckets[interval % capacity];
+    IntervalStats read;
+
+    uint64_t before = bucket->interval.load(std::memory_order_acquire);
+
+    //A later interval took the bucket over (or is about to) , an earlier one means nothing arrived in this one
+    if(before != interval)
+        return (before < interval || before == UINT64_MAX);
+
+    read.bytes         = bucket->bytes.load(std::memory_order_relaxed);
+    read.bytesWll      = bucket->bytesWll.load(std::memory_order_relaxed);
+    read.packets       = bucket->packets.load(std::memory_order_relaxed);
+    read.sent          = bucket->sent.load(std::memory_order_relaxed);
+    read.jitterTotal   = bucket->jitterTotal.load(std::memory_order_relaxed);
+    read.jitterSquares = bucket->jitterSquares.load(std::memory_order_relaxed);
+    for(uint32_t bin = 0; bin < INTERVAL_LATENCY_BINS; bin++)
+        read.latency[bin] = bucket->latency[bin].load(std::memory_order_relaxed);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if(bucket->interval.load(std::memory_order_relaxed) != interval)
+        return false;
+
+    stats->Add(read);
+
+    return true;
+}
@@ -0,0 +1,96 @@
+#ifndef _INTERVAL_RING_H_
+#define _INTERVAL_RING_H_
+
+#include "Utilities.h"
+
+#include <atomic>
+
+#define DEFAULT_INTERVAL_BUCKET     100     // ms , the datagrams of a stream are counted per interval of this length
+#define DEFAULT_RETENTION           60      // seconds of intervals that every stream keeps
+#define MAX_INTERVAL_BUCKETS        1000000 // per stream , a longer retention is cut to it
+#define INTERVAL_LATENCY_BINS       24      // powers of two of microseconds , under 1us up to 4.2s and later
+
+//What arrived in one or more intervals , of one or more streams
+struct IntervalStats
+{
+    uint64_t bytes;
+    uint64_t bytesWll;
+    uint64_t packets;
+    uint64_t sent;                      // how far the highest sequence number moved
+    double   jitterTotal;               // |D| of RFC 3550 , and its squares
+    double   jitterSquares;
+    uint64_t latency[INTERVAL_LATENCY_BINS];
+
+    void Reset();
+
+    void Add(const IntervalStats& stats);
+
+    double GetThroughtput(double duration);
+
+    double GetGoodput(double duration);
+
+    double GetPacketLostPercentage();
+
+    //The mean |D| in ms , and its standard deviation (seconds , like the one of the whole test)
+    double GetJitter();
+
+    double GetJitterStandardDeviation();
+
+    //The lowest latency of a bin (us)
+    static uint64_t GetLatencyBinStart(uint32_t bin);
+};
+
+//The intervals of a stream , as a ring of fixed length buckets that holds the last "retention" worth of them.
+//The buckets of every stream start at the same epoch , so the intervals of the streams add up.
+//
+//A single thread pushes , any thread may read meanwhile. The counters are relaxed atomics (a plain store on the
+//push path) , a bucket that is being taken over by a newer interval is marked first so a reader never takes it
+//for the old one.
+class IntervalRing
+{
+private:
+    struct Bucket
+    {
+        std::atomic<uint64_t> interval;
+        std::atomic<uint64_t> bytes;
+        std::atomic<uint64_t> bytesWll;
+        std::atomic<uint64_t> packets;
+        std::atomic<uint64_t> sent;
+        std::atomic<double>   jitterTotal;
+        std::atomic<double>   jitterSquares;
+        std::atomic<uint32_t> latency[INTERVAL_LATENCY_BINS];
+    };
+
+    Bucket*  buckets;
+    uint32_t capacity;
+    uint64_t bucketNano;
+    uint64_t epoch;
+
+    //The owner thread
+    uint64_t currentInterval;
+    Bucket*  current;
+
+    template <typename T> static inline void Add(std::atomic<T>& counter , T value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value , std::memory_order_relaxed);
+    }
+
+public:
+    IntervalRing();
+
+    ~IntervalRing();
+
+    //"_capacity" buckets of "_bucketNano" , the first one starts at "_epoch"
+    void Setup(uint64_t _epoch , uint64_t _bucketNano , uint32_t _capacity);
+
+    //The owner thread only. A datagram that arrived before the current interval (a kernel timestamp) counts in it.
+    void Push(uint64_t arrivalNano , uint64_t bytes , uint64_t bytesWll , uint64_t sent , double jitter , uint64_t latencyNano);
+
+    //Adds the interval to "stats" , false once the ring no longer holds it
+    bool Get(uint64_t interval , IntervalStats* stats) const;
+
+    //The interval that "timeNano" falls in
+    uint64_t GetInterval(uint64_t timeNano) const;
+};
+
+#endif
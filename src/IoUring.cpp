@@ -0,0 +1,299 @@
+#include "IoUring.h"
+
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+IoUring::IoUring()
+{
+    ringId          = -1;
+
+    sqRing          = NULL;
+    sqRingSize      = 0;
+    sqes            = NULL;
+    sqesSize        = 0;
+    sqLocalTail     = 0;
+    sqSubmitted     = 0;
+
+    cqRing          = NULL;
+    cqRingSize      = 0;
+
+    buffers         = NULL;
+    bufferCount     = 0;
+    bufferSize      = 0;
+    recycleFirst    = 0;
+    recycleCount    = 0;
+    recycledBuffers = 0;
+
+    totalSyscalls   = 0;
+}
+
+IoUring::~IoUring()
+{
+    Release();
+}
+
+bool IoUring::Setup(uint32_t entries)
+{
+    struct io_uring_params params;
+
+    memset(&params , 0 , sizeof(struct io_uring_params));
+
+    //Only this thread submits , and it reaps the completions itself (no interrupts for the task work)
+    params.flags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_COOP_TASKRUN;
+
+    ringId = syscall(__NR_io_uring_setup , entries , &params);
+    if(ringId < 0 && errno == EINVAL)
+    {
+        //Older kernels do not know the flags
+        memset(&params , 0 , sizeof(struct io_uring_params));
+        ringId = syscall(__NR_io_uring_setup , entries , &params);
+    }
+    if(ringId < 0)
+        return false;
+
+    sqRingSize = params.sq_off.array + (params.sq_entries * sizeof(uint32_t));
+    cqRingSize = params.cq_off.cqes + (params.cq_entries * sizeof(struct io_uring_cqe));
+    sqesSize   = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    //Both rings share a single mapping on every kernel that matters
+    if(params.features & IORING_FEAT_SINGLE_MMAP)
+        sqRingSize = cqRingSize = std::max(sqRingSize , cqRingSize);
+
+    sqRing = (uint8_t*)mmap(NULL , sqRingSize , PROT_READ | PROT_WRITE , MAP_SHARED | MAP_POPULATE , ringId , IORING_OFF_SQ_RING);
+    if(sqRing == MAP_FAILED)
+    {
+        sqRing = NULL;
+        Release();
+        return false;
+    }
+
+    if(params.features & IORING_FEAT_SINGLE_MMAP)
+        cqRing = sqRing;
+    else
+    {
+        cqRing = (uint8_t*)mmap(NULL , cqRingSize , PROT_READ | PROT_WRITE , MAP_SHARED | MAP_POPULATE , ringId , IORING_OFF_CQ_RING);
+        if(cqRing == MAP_FAILED)
+        {
+            cqRing = NULL;
+            Release();
+            return false;
+        }
+    }
+
+    sqes = (struct io_uring_sqe*)mmap(NULL , sqesSize , PROT_READ | PROT_WRITE , MAP_SHARED | MAP_POPULATE , ringId , IORING_OFF_SQES);
+    if(sqes == MAP_FAILED)
+    {
+        sqes = NULL;
+        Release();
+        return false;
+    }
+
+    sqHead    = (uint32_t*)(sqRing + params.sq_off.head);
+    sqTail    = (uint32_t*)(sqRing + params.sq_off.tail);
+    sqMask    = *(uint32_t*)(sqRing + params.sq_off.ring_mask);
+    sqEntries = *(uint32_t*)(sqRing + params.sq_off.ring_entries);
+    sqArray   = (uint32_t*)(sqRing + params.sq_off.array);
+
+    cqHead    = (uint32_t*)(cqRing + params.cq_off.head);
+    cqTail    = (uint32_t*)(cqRing + params.cq_off.tail);
+    cqMask    = *(uint32_t*)(cqRing + params.cq_off.ring_mask);
+    cqes      = (struct io_uring_cqe*)(cqRing + params.cq_off.cqes);
+
+    //The entries are used in order , so the indirection array never changes
+    for(uint32_t entry = 0; entry < sqEntries; entry++)
+        sqArray[entry] = entry;
+
+    sqLocalTail = sqSubmitted = *sqTail;
+
+    return true;
+}
+
+void IoUring::Release()
+{
+    if(buffers)
+        munmap(buffers , (uint64_t)bufferCount * bufferSize);
+    if(sqes)
+        munmap(sqes , sqesSize);
+    if(cqRing && cqRing != sqRing)
+        munmap(cqRing , cqRingSize);
+    if(sqRing)
+        munmap(sqRing , sqRingSize);
+    if(ringId >= 0)
+        close(ringId);
+
+    ringId     = -1;
+    buffers    = NULL;
+    sqes       = NULL;
+    cqRing     = NULL;
+    sqRing     = NULL;
+}
+
+int IoUring::Enter(uint32_t toSubmit , uint32_t minComplete , uint32_t flags)
+{
+    totalSyscalls++;
+
+    return syscall(__NR_io_uring_enter , ringId , toSubmit , minComplete , flags , NULL , 0);
+}
+
+struct io_uring_sqe* IoUring::GetSqe()
+{
+    uint32_t head = __atomic_load_n(sqHead , __ATOMIC_ACQUIRE);
+
+    if(sqLocalTail - head >= sqEntries)
+        return NULL;
+
+    struct io_uring_sqe* sqe = &sqes[sqLocalTail & sqMask];
+    sqLocalTail++;
+
+    memset(sqe , 0 , sizeof(struct io_uring_sqe));
+    return sqe;
+}
+
+int IoUring::Submit(uint32_t waitFor)
+{
+    if(!FlushRecycled())
+        return -1;
+
+    return SubmitQueued(waitFor);
+}
+
+int IoUring::SubmitQueued(uint32_t waitFor)
+{
+    uint32_t toSubmit = sqLocalTail - sqSubmitted;
+
+    //The kernel sees the new entries once the tail moves
+    __atomic_store_n(sqTail , sqLocalTail , __ATOMIC_RELEASE);
+    sqSubmitted     = sqLocalTail;
+    recycledBuffers = 0;
+
+    if(!toSubmit && !waitFor)
+        return 0;
+
+    return Enter(toSubmit , waitFor , waitFor ? IORING_ENTER_GETEVENTS : 0);
+}
+
+struct io_uring_cqe* IoUring::PeekCqe()
+{
+    uint32_t head = *cqHead;
+
+    if(head == __atomic_load_n(cqTail , __ATOMIC_ACQUIRE))
+        return NULL;
+
+    return &cqes[head & cqMask];
+}
+
+void IoUring::SeenCqe()
+{
+    __atomic_store_n(cqHead , *cqHead + 1 , __ATOMIC_RELEASE);
+}
+
+// =======================================================================================================================================
+// ================================================== Provided Buffers ===================================================================
+// =======================================================================================================================================
+
+bool IoUring::SetupBuffers(uint32_t _bufferCount , uint32_t _bufferSize)
+{
+    bufferCount = _bufferCount;
+    bufferSize  = _bufferSize;
+
+    buffers = (uint8_t*)mmap(NULL , (uint64_t)bufferCount * bufferSize , PROT_READ | PROT_WRITE , MAP_PRIVATE | MAP_ANONYMOUS , -1 , 0);
+    if(buffers == MAP_FAILED)
+    {
+        buffers = NULL;
+        return false;
+    }
+
+    //The whole block in a single request , and wait until the kernel has it
+    recycleFirst = 0;
+    recycleCount = bufferCount;
+    if(!FlushRecycled(true) || SubmitQueued(1) < 0)
+        return false;
+
+    struct io_uring_cqe* cqe = PeekCqe();
+    if(!cqe)
+        return false;
+
+    int result = cqe->res;
+    SeenCqe();
+
+    if(result < 0)
+    {
+        errno = -result;
+        return false;
+    }
+
+    return true;
+}
+
+void IoUring::RecycleBuffer(uint16_t bufferId)
+{
+    recycledBuffers++;
+
+    //The buffers mostly come back in order , so a run of them goes back with a single request
+    if(recycleCount && bufferId == recycleFirst + recycleCount)
+    {
+        recycleCount++;
+        return;
+    }
+
+    FlushRecycled();
+
+    recycleFirst = bufferId;
+    recycleCount = 1;
+}
+
+bool IoUring::FlushRecycled(bool complete)
+{
+    if(!recycleCount)
+        return true;
+
+    struct io_uring_sqe* sqe = GetSqe();
+    if(!sqe)
+    {
+        //The submission queue is full , hand it over first
+        SubmitQueued(0);
+        if(!(sqe = GetSqe()))
+            return false;
+    }
+
+    sqe->opcode    = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd        = recycleCount;
+    sqe->addr      = (uint64_t)GetBuffer(recycleFirst);
+    sqe->len       = bufferSize;
+    sqe->off       = recycleFirst;
+    sqe->buf_group = IO_URING_RECV_GROUP;
+    sqe->user_data = IO_URING_PROVIDE_BUFFERS;
+
+    //Only a failure completes , unless the caller waits for it
+    if(!complete)
+        sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+
+    recycleCount = 0;
+
+    return true;
+}
+
+// =======================================================================================================================================
+// ================================================== Requests ===========================================================================
+// =======================================================================================================================================
+
+void IoUring::PrepareSendMsg(struct io_uring_sqe* sqe , int socketId , struct msghdr* header , int flags , uint64_t userData)
+{
+    sqe->opcode    = IORING_OP_SENDMSG;
+    sqe->fd        = socketId;
+    sqe->addr      = (uint64_t)header;
+    sqe->len       = 1;
+    sqe->msg_flags = flags;
+    sqe->user_data = userData;
+}
+
+void IoUring::PrepareRecvMultishot(struct io_uring_sqe* sqe , int socketId , uint64_t userData)
+{
+    sqe->opcode    = IORING_OP_RECV;
+    sqe->fd        = socketId;
+    sqe->ioprio    = IORING_RECV_MULTISHOT;
+    sqe->flags     = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = IO_URING_RECV_GROUP;
+    sqe->user_data = userData;
+}
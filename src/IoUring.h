@@ -0,0 +1,117 @@
+#ifndef _IO_URING_H_
+#define _IO_URING_H_
+
+#include "Utilities.h"
+
+#include <linux/io_uring.h>
+
+#define IO_URING_RECV_BUFFERS   512        // provided buffers of a receiving stream (a power of two)
+#define IO_URING_MAX_BUFFERS    32768      // of a ring , whatever its number of streams
+#define IO_URING_RECYCLE_BATCH  32         // buffers a receiver holds back before it hands them over
+#define IO_URING_RECV_GROUP     0
+#define IO_URING_PROVIDE_BUFFERS UINT64_MAX // user data of the requests that hand buffers to the kernel
+#define IO_URING_MAX_BATCHES    16         // batches of different streams that a sender submits together
+
+//A minimal io_uring over the raw system calls (no liburing). One ring per thread , never shared.
+//
+//The sender queues the sendmsg of many streams and submits them with a single io_uring_enter. The receiver
+//arms a multishot recv per stream that keeps filling the buffers it provided to the kernel , and waits
+//on the ring with epoll (the ring is readable once it has completions).
+class IoUring
+{
+private:
+    int ringId;
+
+    //Submission queue
+    uint8_t*  sqRing;
+    size_t    sqRingSize;
+    uint32_t* sqHead;
+    uint32_t* sqTail;
+    uint32_t  sqMask;
+    uint32_t  sqEntries;
+    uint32_t* sqArray;
+    struct io_uring_sqe* sqes;
+    size_t    sqesSize;
+    uint32_t  sqLocalTail;
+    uint32_t  sqSubmitted;
+
+    //Completion queue
+    uint8_t*  cqRing;
+    size_t    cqRingSize;
+    uint32_t* cqHead;
+    uint32_t* cqTail;
+    uint32_t  cqMask;
+    struct io_uring_cqe* cqes;
+
+    //Provided buffers , the kernel picks one for every datagram it receives
+    uint8_t*  buffers;
+    uint32_t  bufferCount;
+    uint32_t  bufferSize;
+    uint16_t  recycleFirst;
+    uint32_t  recycleCount;
+    uint32_t  recycledBuffers;   // since the last submit
+
+    int Enter(uint32_t toSubmit , uint32_t minComplete , uint32_t flags);
+
+    int SubmitQueued(uint32_t waitFor);
+
+    //Queues the run of recycled buffers , it goes out with the next submit
+    bool FlushRecycled(bool complete = false);
+
+public:
+    //Every io_uring_enter , to compare with the plain system calls
+    uint64_t totalSyscalls;
+
+    IoUring();
+
+    ~IoUring();
+
+    bool Setup(uint32_t entries);
+
+    void Release();
+
+    //NULL when the submission queue is full
+    struct io_uring_sqe* GetSqe();
+
+    //Submits whatever is queued (the recycled buffers too) and waits for "waitFor" completions
+    int Submit(uint32_t waitFor);
+
+    struct io_uring_cqe* PeekCqe();
+
+    void SeenCqe();
+
+    inline int GetRingId()
+    {
+        return ringId;
+    }
+
+    // =======================================================================================================================================
+    // ================================================== Provided Buffers ===================================================================
+    // =======================================================================================================================================
+
+    bool SetupBuffers(uint32_t _bufferCount , uint32_t _bufferSize);
+
+    inline uint8_t* GetBuffer(uint16_t bufferId)
+    {
+        return buffers + ((uint64_t)bufferId * bufferSize);
+    }
+
+    //Hands the buffer back to the kernel (with the next submit)
+    void RecycleBuffer(uint16_t bufferId);
+
+    inline uint32_t GetRecycledBuffers()
+    {
+        return recycledBuffers;
+    }
+
+    // =======================================================================================================================================
+    // ================================================== Requests ===========================================================================
+    // =======================================================================================================================================
+
+    static void PrepareSendMsg(struct io_uring_sqe* sqe , int socketId , struct msghdr* header , int flags , uint64_t userData);
+
+    //A single request that completes once per datagram , into the provided buffers
+    static void PrepareRecvMultishot(struct io_uring_sqe* sqe , int socketId , uint64_t userData);
+};
+
+#endif
@@ -0,0 +1,118 @@
+#include "LatencyHistogram.h"
+
+#include <cmath>
+#include <algorithm>
+
+LatencyHistogram::LatencyHistogram()
+{
+    Reset();
+}
+
+void LatencyHistogram::Reset()
+{
+    for(uint32_t bucket = 0; bucket < LATENCY_BUCKETS; bucket++)
+        buckets[bucket].store(0 , std::memory_order_relaxed);
+
+    count.store(0 , std::memory_order_relaxed);
+    total.store(0 , std::memory_order_relaxed);
+    minimum.store(UINT64_MAX , std::memory_order_relaxed);
+    maximum.store(0 , std::memory_order_relaxed);
+}
+
+uint32_t LatencyHistogram::GetBucket(uint64_t value)
+{
+    value = std::min<uint64_t>(value , (2ULL << LATENCY_HIGHEST_BIT) - 1);
+
+    //The values of the first 128 buckets are their index , above that the highest bit picks the power of two
+    //and the next six bits the bucket in it
+    int highestBit = 63 - __builtin_clzll(value | 1);
+    int shift      = std::max(highestBit - LATENCY_SUB_BUCKET_BITS , 0);
+
+    return (shift << LATENCY_SUB_BUCKET_BITS) + (value >> shift);
+}
+
+uint64_t LatencyHistogram::GetBucketValue(uint32_t bucket)
+{
+    int      shift = std::max<int>((bucket >> LATENCY_SUB_BUCKET_BITS) - 1 , 0);
+    uint64_t first = (uint64_t)(bucket - (shift << LATENCY_SUB_BUCKET_BITS)) << shift;
+
+    return first + (1ULL << shift) - 1;
+}
+
+void LatencyHistogram::Record(uint64_t latencyNano)
+{
+    Add(buckets[GetBucket(latencyNano)] , 1);
+    Add(count , 1);
+    Add(total , latencyNano);
+
+    if(latencyNano < minimum.load(std::memory_order_relaxed))
+        minimum.store(latencyNano , std::memory_order_relaxed);
+    if(latencyNano > maximum.load(std::memory_order_relaxed))
+        maximum.store(latencyNano , std::memory_order_relaxed);
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram* histogram)
+{
+    uint64_t merged = 0;
+
+    for(uint32_t bucket = 0; bucket < LATENCY_BUCKETS; bucket++)
+    {
+        uint64_t value = histogram->buckets[bucket].load(std::memory_order_relaxed);
+
+        Add(buckets[bucket] , value);
+        merged += value;
+    }
+
+    //The buckets may have moved on since the count was read , the count is the one of the buckets
+    Add(count , merged);
+    Add(total , histogram->total.load(std::memory_order_relaxed));
+
+    minimum.store(std::min(minimum.load(std::memory_order_relaxed) , histogram->minimum.load(std::memory_order_relaxed)) , std::memory_order_relaxed);
+    maximum.store(std::max(maximum.load(std::memory_order_relaxed) , histogram->maximum.load(std::memory_order_relaxed)) , std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::GetCount() const
+{
+    return count.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::GetPercentile(double percentile) const
+{
+    uint64_t latencies = count.load(std::memory_order_relaxed);
+    uint64_t seen      = 0;
+
+    if(!latencies)
+        return 0;
+
+    uint64_t rank = std::max<uint64_t>((uint64_t)std::ceil((percentile / 100.0) * latencies) , 1);
+
+    for(uint32_t bucket = 0; bucket < LATENCY_BUCKETS; bucket++)
+    {
+        seen += buckets[bucket].load(std::memory_order_relaxed);
+
+        //No bucket reports past the latencies that were actually seen
+        if(seen >= rank)
+            return std::min(std::max(GetBucketValue(bucket) , minimum.load(std::memory_order_relaxed)) , maximum.load(std::memory_order_relaxed));
+    }
+
+    return maximum.load(std::memory_order_relaxed);
+}
+
+void LatencyHistogram::GetSummary(LatencySummary* summary) const
+{
+    uint64_t latencies = count.load(std::memory_order_relaxed);
+
+    if(!latencies)
+    {
+        *summary = LatencySummary{0.0 , 0.0 , 0.0 , 0.0 , 0.0 , 0.0 , 0.0};
+        return;
+    }
+
+    summary->min  = minimum.load(std::memory_order_relaxed) / 1000000.0;
+    summary->mean = (total.load(std::memory_order_relaxed) / (double)latencies) / 1000000.0;
+    summary->p50  = GetPercentile(50.0) / 1000000.0;
+    summary->p90  = GetPercentile(90.0) / 1000000.0;
+    summary->p99  = GetPercentile(99.0) / 1000000.0;
+    summary->p999 = GetPercentile(99.9) / 1000000.0;
+    summary->max  = maximum.load(std::memory_order_relaxed) / 1000000.0;
+}
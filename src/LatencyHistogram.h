@@ -0,0 +1,69 @@
+#ifndef _LATENCY_HISTOGRAM_H_
+#define _LATENCY_HISTOGRAM_H_
+
+#include <cstdint>
+#include <atomic>
+
+#define LATENCY_SUB_BUCKET_BITS 6                                   // 64 linear buckets per power of two , at most 1.6% off
+#define LATENCY_SUB_BUCKETS     (1 << LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_HIGHEST_BIT     37                                  // ~275s in nanoseconds , anything later counts as that
+#define LATENCY_BUCKETS         ((LATENCY_HIGHEST_BIT - LATENCY_SUB_BUCKET_BITS + 2) * LATENCY_SUB_BUCKETS)
+
+//What the reports show of a histogram , in milliseconds
+struct LatencySummary
+{
+    double min;
+    double mean;
+    double p50;
+    double p90;
+    double p99;
+    double p999;
+    double max;
+};
+
+//A log-linear (HDR) histogram of latencies in nanoseconds. Below 128ns every value has a bucket of its own , above
+//that every power of two is split in 64 buckets , so a value lands in its bucket with a shift and two adds.
+//The count , the sum , the min and the max are exact , and two histograms merge without losing anything.
+//
+//A single thread records , any thread may read it meanwhile (too large to copy at every drain , every bucket
+//is a relaxed atomic instead , a plain store on the record path).
+class LatencyHistogram
+{
+private:
+    std::atomic<uint64_t> buckets[LATENCY_BUCKETS];
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> total;
+    std::atomic<uint64_t> minimum;
+    std::atomic<uint64_t> maximum;
+
+    static uint32_t GetBucket(uint64_t value);
+
+    //The highest value that lands in "bucket"
+    static uint64_t GetBucketValue(uint32_t bucket);
+
+    //The owner thread only , a load and a store (no locked instruction)
+    static inline void Add(std::atomic<uint64_t>& counter , uint64_t value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value , std::memory_order_relaxed);
+    }
+
+public:
+    LatencyHistogram();
+
+    void Reset();
+
+    //The owner thread only
+    void Record(uint64_t latencyNano);
+
+    //Adds "histogram" to this one , which belongs to the calling thread
+    void Merge(const LatencyHistogram* histogram);
+
+    uint64_t GetCount() const;
+
+    //The value that "percentile" percent of the latencies are at or below (nanoseconds)
+    uint64_t GetPercentile(double percentile) const;
+
+    void GetSummary(LatencySummary* summary) const;
+};
+
+#endif
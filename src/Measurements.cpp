@@ -1,6 +1,7 @@
 #include "Measurements.h"
 
 #include <math.h>
+#include <algorithm>
 
 Measurements::Measurements() 
 {
@@ -20,16 +21,17 @@ void Measurements::Reset()
     packetLost   = 0;
     totalPackets = 0;
     totalPacketsThatTheClientHaveSend = 0;
+    localDrops   = 0;
+
+    //Reset reordering
+    reordered        = 0;
+    reorderExtent    = 0;
+    maxReorderExtent = 0;
+    duplicates       = 0;
     
     //Reset jitter and the standard deviation
-    jitter          = 0.0f;
-    variance        = 0.0f;
-    totalJitter     = 0.0f;
-    jitterDeviation = 0.0f;
-    mean            = 0.0f;
-
-    //Reset one way delay
-    oneWayDelay = 0.0f;
+    jitter = 0.0f;
+    jitterStatistics.Reset();
 }
 
 // ======================================================================================================================================= 
@@ -42,18 +44,6 @@ double Measurements::GetThroughtput()
     return averageThroughtput;
 }
 
-void Measurements::CombineThroughtputs(Measurements* mes1 , const Measurements* mes2)
-{
-    //README
-    //Epeidh esteila mail kai h aporia mou den lu8hke...an bgaleis apo ta sxolia auto perneis to "average" anamesa se 2 average throughtput
-    //To idio isxuei parakatw gia to goodput.
-
-    // mes1->averageThroughtput =  (mes1->averageThroughtput * (mes1->timeUntilNow / (mes1->timeUntilNow + mes2->timeUntilNow))) +
-    //                             (mes2->averageThroughtput * (mes2->timeUntilNow / (mes1->timeUntilNow + mes2->timeUntilNow)));
-    
-    mes1->averageThroughtput = (mes1->averageThroughtput + mes2->averageThroughtput);
-}
-
 // ======================================================================================================================================= 
 // =================================================  Goodput ============================================================================ 
 // =======================================================================================================================================
@@ -64,14 +54,6 @@ double Measurements::GetGoodput()
     return averageGoodput;
 }
 
-void Measurements::CombineGoodputs(Measurements* mes1 , const Measurements* mes2)
-{
-    // mes1->averageGoodput =  (mes1->averageGoodput * (mes1->timeUntilNow / (mes1->timeUntilNow + mes2->timeUntilNow))) +
-    //                         (mes2->averageGoodput * (mes2->timeUntilNow / (mes1->timeUntilNow + mes2->timeUntilNow)));
-    
-    mes1->averageGoodput = (mes1->averageGoodput + mes2->averageGoodput);
-}
-
 // ======================================================================================================================================= 
 // =====================================================  Jitter ========================================================================= 
 // ======================================================================================================================================= 
@@ -84,78 +66,92 @@ double Measurements::GetJitter()
 
 double Measurements::GetJitterStandardDeviation()
 {
-    return jitterDeviation;
+    return jitterStatistics.GetStandardDeviation();
 }
 
-double Measurements::PushJitter(double nowJitter)
+void Measurements::PushJitter(double dt)
 {
-    variance = ((totalPackets - 1) / (double)totalPackets) * 
-               ( variance + (pow((nowJitter - mean),2.0) / (double)totalPackets));
-    
-    totalJitter += nowJitter;
+    //We calculate the jitter using the RTP protocol formula , J += (|D| - J) / 16
+    double update = dt - jitter;
 
-    mean = totalJitter / totalPackets;
+    jitter += update / 16.0;
 
-    jitterDeviation = sqrt(variance);
+    jitterStatistics.Push(update);
 }
 
-void Measurements::CombineJitters(Measurements* mes1 , const Measurements* mes2)
-{
-    //Compine 2 average jitters
+// ======================================================================================================================================= 
+// ================================================== Packet Lost ======================================================================== 
+// ======================================================================================================================================= 
 
-    mes1->jitter =  (mes1->jitter * 16/32) + (mes2->jitter * 16/32);
+double Measurements::GetPacketLostPercentage()
+{
+    //return the packet lost percentage
+    return 100.0 * (double) ( (double) packetLost / (double) totalPacketsThatTheClientHaveSend);
 }
 
-void Measurements::CombineJittersDeviations(Measurements* mes1 , const Measurements* mes2)
+double Measurements::GetNetworkLossPercentage()
 {
-    //Combine 2 standard deviations 
+    uint64_t networkLost = (packetLost > localDrops) ? packetLost - localDrops : 0;
 
-    double mean;
-    double standardDeviation;
+    return 100.0 * (double) ( (double) networkLost / (double) totalPacketsThatTheClientHaveSend);
+}
 
-    mean  = ((mes1->totalPackets * mes1->mean) + (mes2->totalPackets * mes2->mean)) / (mes1->totalPackets + mes2->totalPackets);
+double Measurements::GetLocalLossPercentage()
+{
+    //A socket may also drop what already counted as lost (a datagram out of the order it was sent)
+    return 100.0 * (double) ( (double) std::min(localDrops , packetLost) / (double) totalPacketsThatTheClientHaveSend);
+}
 
-    standardDeviation = ( ((mes1->totalPackets - 1) * (mes1->jitterDeviation * mes1->jitterDeviation)) + 
-                          ((mes2->totalPackets - 1) * (mes2->jitterDeviation * mes2->jitterDeviation)) +
-                          (mes1->totalPackets * pow((mes1->mean - mean) , 2)) +
-                          (mes2->totalPackets * pow((mes2->mean - mean) , 2)) ) /
-                          (mes1->totalPackets + mes2->totalPackets - 1);
-    
-    mes1->jitterDeviation = sqrt(standardDeviation);
+uint64_t Measurements::GetUniquePackets()
+{
+    return (totalPackets > duplicates) ? totalPackets - duplicates : 0;
 }
 
 // ======================================================================================================================================= 
-// ================================================== Packet Lost ======================================================================== 
+// ================================================== Reordering ========================================================================= 
 // ======================================================================================================================================= 
 
-double Measurements::GetPacketLostPercentage()
+double Measurements::GetReorderedPercentage()
 {
-    //return the packet lost percentage
-    return 100.0 * (double) ( (double) packetLost / (double) totalPacketsThatTheClientHaveSend);
+    uint64_t uniquePackets = GetUniquePackets();
+
+    return uniquePackets ? (100.0 * reordered) / uniquePackets : 0.0;
 }
 
-void Measurements::CombinePacketLost(Measurements* mes1 , const Measurements* mes2)
+double Measurements::GetMeanReorderExtent()
 {
-    //compine the packet lost and the total packets between 2 streams
-
-    mes1->totalPackets += mes2->totalPackets;
-    mes1->packetLost   += mes2->packetLost;
-    mes1->totalPacketsThatTheClientHaveSend += mes2->totalPacketsThatTheClientHaveSend; 
+    return reordered ? reorderExtent / (double)reordered : 0.0;
 }
 
 // ======================================================================================================================================= 
-// ================================================== One Way Delay ====================================================================== 
-// =======================================================================================================================================
+// ================================================== Combine ============================================================================ 
+// ======================================================================================================================================= 
 
-double Measurements::GetOneWayDelay()
+void Measurements::Combine(Measurements* mes1 , const Measurements* mes2)
 {
-    //return the one way delay in ms
-    return oneWayDelay * 1000;
-}
+    uint64_t totalPackets = mes1->totalPackets + mes2->totalPackets;
 
-void Measurements::CombineOneWayDelay(Measurements* mes1 , const Measurements* mes2)
-{
-    //Compine 2 one way delays 
+    //The mean of the jitters of every packet , whatever stream it came with
+    if(totalPackets)
+        mes1->jitter = ((mes1->jitter * mes1->totalPackets) + (mes2->jitter * mes2->totalPackets)) / totalPackets;
+
+    RunningStatistics::Combine(&mes1->jitterStatistics , &mes2->jitterStatistics);
+
+    //The streams run in parallel , their rates add up
+    mes1->averageThroughtput += mes2->averageThroughtput;
+    mes1->averageGoodput     += mes2->averageGoodput;
+    mes1->timeUntilNow        = std::max(mes1->timeUntilNow , mes2->timeUntilNow);
+
+    mes1->totalBytesReceived    += mes2->totalBytesReceived;
+    mes1->totalBytesReceivedWll += mes2->totalBytesReceivedWll;
+
+    mes1->totalPackets  = totalPackets;
+    mes1->packetLost   += mes2->packetLost;
+    mes1->totalPacketsThatTheClientHaveSend += mes2->totalPacketsThatTheClientHaveSend;
+    mes1->localDrops   += mes2->localDrops;
 
-    mes1->oneWayDelay = ((mes1->oneWayDelay + mes2->oneWayDelay) / 2.0); 
+    mes1->reordered        += mes2->reordered;
+    mes1->reorderExtent    += mes2->reorderExtent;
+    mes1->maxReorderExtent  = std::max(mes1->maxReorderExtent , mes2->maxReorderExtent);
+    mes1->duplicates       += mes2->duplicates;
 }
\ No newline at end of file
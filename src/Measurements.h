@@ -1,6 +1,8 @@
 #ifndef _MEASUREMENTS_H_
 #define _MEASUREMENTS_H_
 
+#include "RunningStatistics.h"
+
 #include <cstdint>
 
 struct Measurements
@@ -13,20 +15,24 @@ public:
     double   averageGoodput;
     double   timeUntilNow;
     
-    //Jitter and the standard deviation
+    //Jitter (RFC 3550) , and the series of its updates for the standard deviation
     double jitter;
-    double variance;
-    double totalJitter;
-    double jitterDeviation;
-    double mean;
+    RunningStatistics jitterStatistics;
 
     //Packet lost
     uint64_t packetLost;
     uint64_t totalPackets;
     uint64_t totalPacketsThatTheClientHaveSend;
 
-    //One Way measurements
-    double oneWayDelay;
+    //The part of the packets lost that the sockets of the server dropped (a full receive queue) , the rest the network did
+    uint64_t localDrops;
+
+    //Reordering (RFC 4737) , the packets that came after a higher sequence number and how many arrivals late
+    uint64_t reordered;
+    uint64_t reorderExtent;
+    uint64_t maxReorderExtent;
+    uint64_t duplicates;
+
 public:
 
     Measurements();
@@ -39,16 +45,12 @@ public:
 
     double GetThroughtput();
 
-    static void CombineThroughtputs(Measurements* mes1 , const Measurements* mes2);
-
     // ======================================================================================================================================= 
     // =================================================  Goodput ============================================================================ 
     // ======================================================================================================================================= 
 
     double GetGoodput();
 
-    static void CombineGoodputs(Measurements* mes1 , const Measurements* mes2);
-
     // ======================================================================================================================================= 
     // =====================================================  Jitter ========================================================================= 
     // ======================================================================================================================================= 
@@ -57,11 +59,8 @@ public:
 
     double GetJitterStandardDeviation();
     
-    double PushJitter(double nowJitter);
-    
-    static void CombineJitters(Measurements* mes1 , const Measurements* mes2);
-    
-    static void CombineJittersDeviations(Measurements* mes1 , const Measurements* mes2);
+    //"dt" the |D| of RFC 3550 , the difference in the transit times of this packet and the previous one
+    void PushJitter(double dt);
 
     // ======================================================================================================================================= 
     // ================================================== Packet Lost ======================================================================== 
@@ -69,15 +68,30 @@ public:
    
     double GetPacketLostPercentage();
 
-    static void CombinePacketLost(Measurements* mes1 , const Measurements* mes2);
+    double GetNetworkLossPercentage();
+
+    double GetLocalLossPercentage();
+
+    //What arrived , a duplicate only once
+    uint64_t GetUniquePackets();
+
+    // ======================================================================================================================================= 
+    // ================================================== Reordering ========================================================================= 
+    // ======================================================================================================================================= 
+
+    double GetReorderedPercentage();
+
+    double GetMeanReorderExtent();
  
     // ======================================================================================================================================= 
-    // ================================================== One Way Delay ====================================================================== 
+    // ================================================== Combine ============================================================================ 
     // ======================================================================================================================================= 
-    
-    double GetOneWayDelay();
 
-    static void CombineOneWayDelay(Measurements* mes1 , const Measurements* mes2);
+    //The streams (or the shards of a stream) received disjoint parts of the traffic over the same time , so the
+    //counters and the rates add up and the jitters are weighted by their packets. Exact in whatever order and
+    //grouping the streams are combined (ReduceTree). What the client sent (and so the packets lost) only adds up
+    //over the streams , the shards of a stream count it again afterwards.
+    static void Combine(Measurements* mes1 , const Measurements* mes2);
 };
 
 #endif
\ No newline at end of file
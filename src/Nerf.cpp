@@ -2,6 +2,63 @@
 #include "Client.h"
 
 #include <signal.h>
+#include <getopt.h>
+
+//Long options without a short equivalent
+enum LongOptions
+{
+  OPTION_BATCH = 256,
+  OPTION_BURST,
+  OPTION_KERNEL_PACING,
+  OPTION_GSO,
+  OPTION_ZEROCOPY,
+  OPTION_HUGEPAGES,
+  OPTION_THREADS,
+  OPTION_PROFILE,
+  OPTION_PROFILE_FILE,
+  OPTION_SEARCH,
+  OPTION_SEARCH_SIZES,
+  OPTION_AFFINITY,
+  OPTION_CONTROL_AFFINITY,
+  OPTION_IO_URING,
+  OPTION_SHARDS,
+  OPTION_SHARD_BY_CPU,
+  OPTION_GRO,
+  OPTION_RX_TIMESTAMPS,
+  OPTION_BUSY_POLL,
+  OPTION_SOCKBUF_CAP,
+  OPTION_BUCKET,
+  OPTION_RETENTION,
+  OPTION_HEATMAP,
+};
+
+static struct option longOptions[] = 
+{
+  {"batch" , required_argument , NULL , OPTION_BATCH},
+  {"burst" , required_argument , NULL , OPTION_BURST},
+  {"kernel-pacing" , required_argument , NULL , OPTION_KERNEL_PACING},
+  {"gso"   , no_argument       , NULL , OPTION_GSO},
+  {"zerocopy" , no_argument    , NULL , OPTION_ZEROCOPY},
+  {"hugepages" , no_argument   , NULL , OPTION_HUGEPAGES},
+  {"threads" , required_argument , NULL , OPTION_THREADS},
+  {"profile" , required_argument , NULL , OPTION_PROFILE},
+  {"profile-file" , required_argument , NULL , OPTION_PROFILE_FILE},
+  {"search" , required_argument , NULL , OPTION_SEARCH},
+  {"search-sizes" , required_argument , NULL , OPTION_SEARCH_SIZES},
+  {"affinity" , required_argument , NULL , OPTION_AFFINITY},
+  {"control-affinity" , required_argument , NULL , OPTION_CONTROL_AFFINITY},
+  {"io-uring" , no_argument , NULL , OPTION_IO_URING},
+  {"shards" , required_argument , NULL , OPTION_SHARDS},
+  {"shard-by-cpu" , no_argument , NULL , OPTION_SHARD_BY_CPU},
+  {"gro" , no_argument , NULL , OPTION_GRO},
+  {"rx-timestamps" , required_argument , NULL , OPTION_RX_TIMESTAMPS},
+  {"busy-poll" , required_argument , NULL , OPTION_BUSY_POLL},
+  {"sockbuf-cap" , required_argument , NULL , OPTION_SOCKBUF_CAP},
+  {"bucket" , required_argument , NULL , OPTION_BUCKET},
+  {"retention" , required_argument , NULL , OPTION_RETENTION},
+  {"heatmap" , required_argument , NULL , OPTION_HEATMAP},
+  {NULL    , 0                 , NULL , 0}
+};
 
 Client* client = nullptr;
 Server* server = nullptr;
@@ -21,6 +78,7 @@ void HandleSignal(int signalKind)
     {
       fprintf(stdout , "\nStop sending data.\nWaiting for the final results...\n\n");
 
+      client->StopSearch();
       client->SendTerminateSignal();
     }
   }
@@ -39,6 +97,28 @@ int main(int argc, char **argv)
   uint8_t  printResultsInter        = 0;
   double   durationInSeconds        = 0;
   uint64_t bandwidth                = 0;
+  uint32_t batchSize                = 0;
+  uint32_t burstSize                = 0;
+  uint8_t  pacingMode               = PACING_USER;
+  uint8_t  useGso                   = 0;
+  uint8_t  useGro                   = 0;
+  uint8_t  rxTimestamps             = RX_TIMESTAMP_USER;
+  uint64_t busyPollNano             = DEFAULT_BUSY_POLL;
+  uint32_t socketBufferCap          = DEFAULT_SOCKET_BUFFER_CAP;
+  uint32_t intervalMilli            = DEFAULT_INTERVAL_BUCKET;
+  uint32_t retention                = DEFAULT_RETENTION;
+  std::string heatmapFileName;
+  uint8_t  useZeroCopy              = 0;
+  uint8_t  useHugePages             = 0;
+  uint8_t  useIoUring               = 0;
+  uint32_t numberOfThreads          = DEFAULT_SENDER_THREADS;
+  uint16_t numberOfShards           = DEFAULT_SHARDS;
+  bool     shardByCpu               = false;
+  TrafficProfile profile;
+  bool     search                   = false;
+  double   searchLossThreshold      = 0.0f;
+  std::vector<uint32_t> searchPacketSizes;
+  Affinity affinity;
   double   waitDuration             = 0.0f;
   double   printResultsInterval     = 0.0f;
 
@@ -47,8 +127,11 @@ int main(int argc, char **argv)
 
   signal(SIGINT , HandleSignal);
 
+  //Every stream is a socket on both sides
+  RaiseFileDescriptorLimit();
+
   int opt;
-  while ((opt = getopt(argc, argv, "a:p:f:i:scl:b:n:t:w:dh")) != -1)
+  while ((opt = getopt_long(argc, argv, "a:p:f:i:scl:b:n:t:w:dh", longOptions, NULL)) != -1)
   {
     switch (opt)
     {
@@ -170,6 +253,293 @@ int main(int argc, char **argv)
         waitDuration = strtod(optarg , NULL);
       }break;
 
+      case OPTION_BATCH:
+      {
+        batchSize = strtol(optarg, NULL, 10);
+
+        if(batchSize < 1 || batchSize > MAX_BATCH_SIZE)
+        {
+          fprintf(stderr, "[Error] : 1 <= Batch Size <= %d.\n", MAX_BATCH_SIZE);
+          return 1;
+        }
+      }break;
+
+      case OPTION_BURST:
+      {
+        if (isServer)
+        {
+          fprintf(stderr, "[Error] : you can not set this option while you running on server mode!\n");
+          return 1;
+        }
+
+        burstSize = strtol(optarg, NULL, 10);
+      }break;
+
+      case OPTION_KERNEL_PACING:
+      {
+        if (isServer)
+        {
+          fprintf(stderr, "[Error] : you can not set this option while you running on server mode!\n");
+          return 1;
+        }
+
+        if(!strcmp(optarg , "rate"))
+          pacingMode = PACING_RATE;
+        else if(!strcmp(optarg , "txtime"))
+          pacingMode = PACING_TXTIME;
+        else
+        {
+          fprintf(stderr, "[Error] : kernel pacing is either \"rate\" or \"txtime\".\n");
+          return 1;
+        }
+      }break;
+
+      case OPTION_GSO:
+      {
+        if (isServer)
+        {
+          fprintf(stderr, "[Error] : you can not set this option while you running on server mode!\n");
+          return 1;
+        }
+
+        useGso = 1;
+      }break;
+
+      case OPTION_ZEROCOPY:
+      {
+        if (isServer)
+        {
+          fprintf(stderr, "[Error] : you can not set this option while you running on server mode!\n");
+          return 1;
+        }
+
+        useZeroCopy = 1;
+      }break;
+
+      case OPTION_HUGEPAGES:
+      {
+        if (isServer)
+        {
+          fprintf(stderr, "[Error] : you can not set this option while you running on server mode!\n");
+          return 1;
+        }
+
+        useHugePages = 1;
+      }break;
+
+      case OPTION_THREADS:
+      {
+        numberOfThreads = strtol(optarg, NULL, 10);
+
+        if(numberOfThreads < 1)
+        {
+          fprintf(stderr, "[Error] : at least one thread is needed.\n");
+          return 1;
+        }
+      }break;
+
+      case OPTION_PROFILE:
+      case OPTION_PROFILE_FILE:
+      {
+        if (isServer)
+        {
+          fprintf(stderr, "[Error] : you can not set this option while you running on server mode!\n");
+          return 1;
+        }
+
+        bool parsed = (opt == OPTION_PROFILE) ? profile.Parse(optarg) : profile.Load(optarg);
+
+        if(!parsed)
+        {
+          fprintf(stderr, "[Error] : invalid traffic profile \"%s\".\n", optarg);
+          return 1;
+        }
+      }break;
+
+      case OPTION_SEARCH:
+      {
+        if (isServer)
+        {
+          fprintf(stderr, "[Error] : you can not set this option while you running on server mode!\n");
+          return 1;
+        }
+
+        search              = true;
+        searchLossThreshold = strtod(optarg, NULL);
+
+        if(searchLossThreshold < 0 || searchLossThreshold >= 100)
+        {
+          fprintf(stderr, "[Error] : the loss threshold is a percentage , 0 <= loss < 100.\n");
+          return 1;
+        }
+      }break;
+
+      case OPTION_SEARCH_SIZES:
+      {
+        if (isServer)
+        {
+          fprintf(stderr, "[Error] : you can not set this option while you running on server mode!\n");
+          return 1;
+        }
+
+        char* size = optarg;
+
+        //Comma separated , every size must hold the sequence number and the timestamp
+        while(*size)
+        {
+          char* end;
+          uint32_t packetSize = strtol(size, &end, 10);
+
+          if(end == size || packetSize < 16)
+          {
+            fprintf(stderr, "[Error] : Packet Size >= 16 bytes.\n");
+            return 1;
+          }
+
+          searchPacketSizes.push_back(packetSize);
+          size = (*end == ',') ? end + 1 : end;
+        }
+      }break;
+
+      case OPTION_AFFINITY:
+      case OPTION_CONTROL_AFFINITY:
+      {
+        bool parsed = (opt == OPTION_AFFINITY) ? affinity.SetStreams(optarg) : affinity.SetControl(optarg);
+
+        if(!parsed)
+        {
+          fprintf(stderr, "[Error] : the affinity is \"nic\" or a CPU list like 0-3,8 .\n");
+          return 1;
+        }
+      }break;
+
+      case OPTION_IO_URING:
+      {
+        useIoUring = 1;
+      }break;
+
+      case OPTION_SHARDS:
+      case OPTION_SHARD_BY_CPU:
+      {
+        if (isClient)
+        {
+          fprintf(stderr, "[Error] : you can not set this option while you running on client mode!\n");
+          return 1;
+        }
+
+        if(opt == OPTION_SHARD_BY_CPU)
+        {
+          shardByCpu = true;
+          break;
+        }
+
+        long shards = strtol(optarg, NULL, 10);
+
+        if(shards < 1 || shards > MAX_SHARDS)
+        {
+          fprintf(stderr, "[Error] : 1 <= Shards <= %d.\n", MAX_SHARDS);
+          return 1;
+        }
+
+        numberOfShards = shards;
+      }break;
+
+      case OPTION_GRO:
+      {
+        if (isClient)
+        {
+          fprintf(stderr, "[Error] : you can not set this option while you running on client mode!\n");
+          return 1;
+        }
+
+        useGro = 1;
+      }break;
+
+      case OPTION_RX_TIMESTAMPS:
+      {
+        if (isClient)
+        {
+          fprintf(stderr, "[Error] : you can not set this option while you running on client mode!\n");
+          return 1;
+        }
+
+        if(!strcmp(optarg , "sw"))
+          rxTimestamps = RX_TIMESTAMP_SOFTWARE;
+        else if(!strcmp(optarg , "hw"))
+          rxTimestamps = RX_TIMESTAMP_HARDWARE;
+        else
+        {
+          fprintf(stderr, "[Error] : receive timestamps are either \"sw\" or \"hw\".\n");
+          return 1;
+        }
+      }break;
+
+      case OPTION_BUSY_POLL:
+      {
+        if (isClient)
+        {
+          fprintf(stderr, "[Error] : you can not set this option while you running on client mode!\n");
+          return 1;
+        }
+
+        long usec = strtol(optarg, NULL, 10);
+
+        if(usec < 1)
+        {
+          fprintf(stderr, "[Error] : the busy poll budget is at least 1us.\n");
+          return 1;
+        }
+
+        busyPollNano = usec * 1000;
+      }break;
+
+      case OPTION_SOCKBUF_CAP:
+      {
+        long cap = strtol(optarg, NULL, 10);
+
+        if(cap < 0 || cap > INT32_MAX)
+        {
+          fprintf(stderr, "[Error] : 0 <= Socket buffer cap <= %d bytes.\n", INT32_MAX);
+          return 1;
+        }
+
+        socketBufferCap = cap;
+      }break;
+
+      case OPTION_BUCKET:
+      case OPTION_RETENTION:
+      {
+        if (isClient)
+        {
+          fprintf(stderr, "[Error] : you can not set this option while you running on client mode!\n");
+          return 1;
+        }
+
+        long value = strtol(optarg, NULL, 10);
+
+        if(value < 1 || value > 86400000)
+        {
+          fprintf(stderr, "[Error] : 1 <= %s <= 86400000.\n", (opt == OPTION_BUCKET) ? "Interval bucket (ms)" : "Retention (s)");
+          return 1;
+        }
+
+        if(opt == OPTION_BUCKET)
+          intervalMilli = value;
+        else
+          retention = value;
+      }break;
+
+      case OPTION_HEATMAP:
+      {
+        if (isClient)
+        {
+          fprintf(stderr, "[Error] : you can not set this option while you running on client mode!\n");
+          return 1;
+        }
+
+        heatmapFileName = optarg;
+      }break;
+
       case 'h':
       {
         PrintUsage();
@@ -197,6 +567,12 @@ int main(int argc, char **argv)
     }
   }
 
+  if (search && (measureOneWay || !profile.IsEmpty()))
+  {
+    fprintf(stderr, "[Error] : the throughput search sets the rate itself , it can not run with -d or a traffic profile.\n");
+    return 1;
+  }
+
   if (isServer)
   {
     if(ip && !port)
@@ -213,6 +589,17 @@ int main(int argc, char **argv)
 
     server->CreateTcpServer();
     server->SetVariables(printInFile , resultsFileName , printResultsInter , printResultsInterval);
+    server->SetAffinity(affinity);
+    server->SetIoUring(useIoUring);
+    server->SetRecvBatchSize(batchSize);
+    server->SetGro(useGro);
+    server->SetRxTimestamps(rxTimestamps);
+    server->SetReceiverThreads(numberOfThreads);
+    server->SetShards(numberOfShards , shardByCpu);
+    server->SetBusyPoll(busyPollNano);
+    server->SetSocketBufferCap(socketBufferCap);
+    server->SetIntervals(intervalMilli , retention);
+    server->SetHeatmap(heatmapFileName);
 
     server->Run();
   }
@@ -230,7 +617,15 @@ int main(int argc, char **argv)
       client = new Client();
     }
     
+    //Without "-t" the test lasts as long as the profile
+    if(!profile.IsEmpty() && !experimentBaseOnTime)
+    {
+      experimentBaseOnTime = 1;
+      durationInSeconds    = (double)profile.GetDuration() / ONE_SECOND_TO_NANO;
+    }
+
     client->CreateTcpClient();
+    client->SetProfile(profile);
     client->SetVariables(udpPacketSize, 
                          bandwidth, 
                          numberOfParallelStreams, 
@@ -241,6 +636,19 @@ int main(int argc, char **argv)
                          resultsFileName,
                          printResultsInterval,
                          printResultsInter);
+    client->SetBatchSize(batchSize);
+    client->SetBurstSize(burstSize);
+    client->SetPacingMode(pacingMode);
+    client->SetGso(useGso);
+    client->SetZeroCopy(useZeroCopy);
+    client->SetHugePages(useHugePages);
+    client->SetSenderThreads(numberOfThreads);
+    client->SetAffinity(affinity);
+    client->SetIoUring(useIoUring);
+    client->SetSocketBufferCap(socketBufferCap);
+
+    if(search)
+      client->SetSearch(searchLossThreshold , searchPacketSizes);
    
     if(waitDuration)
     {
@@ -96,19 +96,17 @@ NerfPacket NerfPacket::MakeSetupPacket(uint32_t udpPacketSize,
     return packet;
 }
 
-NerfPacket NerfPacket::MakePortNumberPacket(std::vector<uint16_t> ports)
+NerfPacket NerfPacket::MakePortNumberPacket(uint16_t firstPort , uint32_t numberOfOpenPorts)
 {
     NerfPacket portsPacket;
-    uint32_t   numberOfOpenPorts = ports.size(); 
 
     portsPacket.flags  = OPEN_PORTS;
-    portsPacket.lenght = (numberOfOpenPorts * sizeof(int)) + sizeof(uint32_t);
+    portsPacket.lenght = sizeof(uint32_t) + sizeof(uint16_t);
 
     memset(portsPacket.payload , 0 , PAYLOAD_SIZE);
 
     memcpy(portsPacket.payload , &numberOfOpenPorts, sizeof(uint32_t));
-    for(uint32_t port = 0; port < numberOfOpenPorts; port++)
-        memcpy(portsPacket.payload + sizeof(uint32_t) + (port * sizeof(uint16_t)), &ports[port], sizeof(uint16_t));
+    memcpy(portsPacket.payload + sizeof(uint32_t) , &firstPort, sizeof(uint16_t));
 
     return portsPacket;
 }
@@ -138,12 +136,37 @@ NerfPacket NerfPacket::MakeLastSequenceNumberPacket(uint16_t port , uint64_t las
     return packet;
 }
 
-NerfPacket NerfPacket::MakeStartPacket()
+NerfPacket NerfPacket::MakeStartPacket(uint64_t startTime)
 {
     NerfPacket packet;
 
     packet.flags  = START;
-    packet.lenght = 0;
+    packet.lenght = sizeof(uint64_t);
+
+    memset(packet.payload, 0, PAYLOAD_SIZE);
+
+    memcpy(packet.payload, &startTime, sizeof(uint64_t));
+
+    return packet;
+}
+
+NerfPacket NerfPacket::MakePhasePacket(uint16_t phase , uint64_t start , uint64_t duration , std::string description)
+{
+    NerfPacket packet;
+    uint32_t   header = sizeof(uint16_t) + (2 * sizeof(uint64_t));
+
+    //The description is cut to what is left of the payload (always null terminated)
+    uint32_t   descriptionLenght = std::min<uint32_t>(description.size() , PAYLOAD_SIZE - header - 1);
+
+    packet.flags  = PHASE;
+    packet.lenght = header + descriptionLenght + 1;
+
+    memset(packet.payload, 0, PAYLOAD_SIZE);
+
+    memcpy(packet.payload,                                        &phase,    sizeof(uint16_t));
+    memcpy(packet.payload + sizeof(uint16_t),                     &start,    sizeof(uint64_t));
+    memcpy(packet.payload + sizeof(uint16_t) + sizeof(uint64_t),  &duration, sizeof(uint64_t));
+    memcpy(packet.payload + header, description.c_str(), descriptionLenght);
 
     return packet;
 }
@@ -153,12 +176,13 @@ NerfPacket NerfPacket::MakeMeasurementsPacket(uint8_t oneWayDelayMes,
                                               double averageGoopput, 
                                               double packetloss, 
                                               double jitter, 
-                                              double jitterDeviation)
+                                              double jitterDeviation,
+                                              double localLoss)
 {
     NerfPacket packet;
 
     packet.flags    = MEASUREMENT;
-    packet.lenght   = (sizeof(uint8_t) + (5 * sizeof(double)));
+    packet.lenght   = (sizeof(uint8_t) + (6 * sizeof(double)));
 
     memset(packet.payload, 0, PAYLOAD_SIZE_IN_BYTES);
     
@@ -168,21 +192,64 @@ NerfPacket NerfPacket::MakeMeasurementsPacket(uint8_t oneWayDelayMes,
     memcpy(packet.payload + sizeof(uint8_t) + (2 * sizeof(double)), &packetloss,        sizeof(double));
     memcpy(packet.payload + sizeof(uint8_t) + (3 * sizeof(double)), &jitter,            sizeof(double));
     memcpy(packet.payload + sizeof(uint8_t) + (4 * sizeof(double)), &jitterDeviation,   sizeof(double));
+    memcpy(packet.payload + sizeof(uint8_t) + (5 * sizeof(double)), &localLoss,         sizeof(double));
 
     return packet;
 }
 
-NerfPacket NerfPacket::MakeMeasurementsPacket(uint8_t oneWayDelayMes , double oneWayDelay)
+NerfPacket NerfPacket::MakeMeasurementsPacket(uint8_t oneWayDelayMes , const LatencySummary& oneWayDelay , double clockError , double clockSkew)
 {
     NerfPacket packet;
 
     packet.flags    = MEASUREMENT;
-    packet.lenght   = (sizeof(uint8_t) + sizeof(double));
+    packet.lenght   = (sizeof(uint8_t) + sizeof(LatencySummary) + (2 * sizeof(double)));
 
     memset(packet.payload, 0, PAYLOAD_SIZE_IN_BYTES);
     
     memcpy(packet.payload, &oneWayDelayMes, sizeof(uint8_t));
-    memcpy(packet.payload + sizeof(uint8_t), &oneWayDelay, sizeof(double));
+    memcpy(packet.payload + sizeof(uint8_t), &oneWayDelay, sizeof(LatencySummary));
+    memcpy(packet.payload + sizeof(uint8_t) + sizeof(LatencySummary), &clockError, sizeof(double));
+    memcpy(packet.payload + sizeof(uint8_t) + sizeof(LatencySummary) + sizeof(double), &clockSkew, sizeof(double));
+
+    return packet;
+}
+
+NerfPacket NerfPacket::MakeClockPacket(uint64_t serverSend , uint64_t clientRecv , uint64_t clientSend)
+{
+    NerfPacket packet;
+
+    packet.flags  = CLOCK;
+    packet.lenght = 3 * sizeof(uint64_t);
+
+    memset(packet.payload, 0, PAYLOAD_SIZE);
+
+    memcpy(packet.payload,                            &serverSend, sizeof(uint64_t));
+    memcpy(packet.payload + sizeof(uint64_t),         &clientRecv, sizeof(uint64_t));
+    memcpy(packet.payload + (2 * sizeof(uint64_t)),   &clientSend, sizeof(uint64_t));
+
+    return packet;
+}
+
+NerfPacket NerfPacket::MakePhaseMeasurementsPacket(uint16_t phase,
+                                                   double averageThroughput, 
+                                                   double averageGoopput, 
+                                                   double packetloss, 
+                                                   double jitter, 
+                                                   double jitterDeviation)
+{
+    NerfPacket packet;
+
+    packet.flags    = PHASE_MEASUREMENT;
+    packet.lenght   = (sizeof(uint16_t) + (5 * sizeof(double)));
+
+    memset(packet.payload, 0, PAYLOAD_SIZE_IN_BYTES);
+    
+    memcpy(packet.payload, &phase, sizeof(uint16_t));
+    memcpy(packet.payload + sizeof(uint16_t),                        &averageThroughput, sizeof(double));
+    memcpy(packet.payload + sizeof(uint16_t) + sizeof(double),       &averageGoopput,    sizeof(double));
+    memcpy(packet.payload + sizeof(uint16_t) + (2 * sizeof(double)), &packetloss,        sizeof(double));
+    memcpy(packet.payload + sizeof(uint16_t) + (3 * sizeof(double)), &jitter,            sizeof(double));
+    memcpy(packet.payload + sizeof(uint16_t) + (4 * sizeof(double)), &jitterDeviation,   sizeof(double));
 
     return packet;
 }
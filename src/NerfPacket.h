@@ -3,6 +3,9 @@
 
 #include <cstdint>
 #include <vector>
+#include <string>
+
+#include "LatencyHistogram.h"
 
 #define SIGNATURE_LEN           4
 #define PAYLOAD_SIZE            100
@@ -20,6 +23,9 @@
 #define ERROR       5
 #define OPEN_PORTS  6
 #define LAST_PACKET 7
+#define PHASE       8
+#define PHASE_MEASUREMENT 9
+#define CLOCK       10
 
 struct NerfPacket
 {
@@ -53,18 +59,35 @@ struct NerfPacket
 
     static NerfPacket MakeLastSequenceNumberPacket(uint16_t port , uint64_t lastPacketSend);
 
-    static NerfPacket MakePortNumberPacket(std::vector<uint16_t> ports);
+    //The open ports are consecutive , [firstPort , firstPort + numberOfOpenPorts)
+    static NerfPacket MakePortNumberPacket(uint16_t firstPort , uint32_t numberOfOpenPorts);
+
+    //"startTime" is when the streams start (client clock) , the phases of a traffic profile are relative to it
+    static NerfPacket MakeStartPacket(uint64_t startTime);
 
-    static NerfPacket MakeStartPacket();
+    static NerfPacket MakePhasePacket(uint16_t phase , uint64_t start , uint64_t duration , std::string description);
 
     static NerfPacket MakeMeasurementsPacket(uint8_t oneWayDelayMes, 
                                              double averageThroughput, 
                                              double averageGoopput, 
                                              double packetloss, 
                                              double jitter, 
-                                             double jitterDeviation);
+                                             double jitterDeviation,
+                                             double localLoss);
     
-    static NerfPacket MakeMeasurementsPacket(uint8_t oneWayDelayMes , double oneWayDelay);
+    //"clockError" (ms) how far the offset between the clocks of the hosts may be from the truth , "clockSkew" (ppm)
+    //how fast they drift apart (0 until the server could estimate it)
+    static NerfPacket MakeMeasurementsPacket(uint8_t oneWayDelayMes , const LatencySummary& oneWayDelay , double clockError , double clockSkew);
+
+    //The server sends it with "serverSend" , the client sends it back with the time it got it and the time it answered
+    static NerfPacket MakeClockPacket(uint64_t serverSend , uint64_t clientRecv , uint64_t clientSend);
+
+    static NerfPacket MakePhaseMeasurementsPacket(uint16_t phase,
+                                                  double averageThroughput, 
+                                                  double averageGoopput, 
+                                                  double packetloss, 
+                                                  double jitter, 
+                                                  double jitterDeviation);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,114 @@
+#include "Pacer.h"
+
+#include <math.h>
+
+// =======================================================================================================================================
+// ================================================== Pacing Statistics ==================================================================
+// =======================================================================================================================================
+
+PacingStatistics::PacingStatistics()
+{
+    Reset();
+}
+
+void PacingStatistics::Reset()
+{
+    errors.Reset();
+}
+
+void PacingStatistics::Push(double error)
+{
+    errors.Push(error);
+}
+
+double PacingStatistics::GetMeanError()
+{
+    //return the mean pacing error in us
+    return errors.GetMean() / 1000.0;
+}
+
+double PacingStatistics::GetErrorDeviation()
+{
+    //return the standard deviation of the pacing error in us
+    return errors.GetSampleStandardDeviation() / 1000.0;
+}
+
+double PacingStatistics::GetMaxError()
+{
+    //return the worst pacing error in us
+    return errors.GetMax() / 1000.0;
+}
+
+void PacingStatistics::CombineStatistics(PacingStatistics* stats1 , const PacingStatistics* stats2)
+{
+    RunningStatistics::Combine(&stats1->errors , &stats2->errors);
+}
+
+// =======================================================================================================================================
+// ======================================================= Pacer =========================================================================
+// =======================================================================================================================================
+
+Pacer::Pacer()
+{
+    Setup(DEFAULT_BANDWIDTH , DEFAULT_UDP_PACKET_SIZE);
+}
+
+void Pacer::Setup(uint64_t bandwidth , uint32_t _burstBytes)
+{
+    bytesPerNano  = (bandwidth / 8.0) / ONE_SECOND_TO_NANO;
+    burstNano     = _burstBytes / bytesPerNano;
+    burstBytes    = _burstBytes;
+    nextDeparture = 0.0f;
+
+    statistics.Reset();
+}
+
+void Pacer::Start(uint64_t start)
+{
+    nextDeparture = start;
+}
+
+uint64_t Pacer::GetNextDeparture(uint64_t now)
+{
+    if(nextDeparture + burstNano < now)
+        nextDeparture = now - burstNano;
+
+    return nextDeparture;
+}
+
+void Pacer::SetBandwidth(uint64_t bandwidth)
+{
+    bytesPerNano = (bandwidth / 8.0) / ONE_SECOND_TO_NANO;
+    burstNano    = burstBytes / bytesPerNano;
+}
+
+void Pacer::Commit(uint32_t bytes)
+{
+    nextDeparture += GetTransmissionTime(bytes);
+}
+
+void Pacer::Delay(double gap)
+{
+    nextDeparture += gap;
+}
+
+void Pacer::Hold(uint64_t until)
+{
+    if(nextDeparture < until)
+        nextDeparture = until;
+}
+
+double Pacer::GetTransmissionTime(uint32_t bytes)
+{
+    //return the time in ns that "bytes" take on the wire at the paced rate
+    return bytes / bytesPerNano;
+}
+
+uint64_t Pacer::Now()
+{
+    Time now;
+
+    SystemClock::GetSystemTime(&now);
+
+    return SystemClock::GetTimeInNanoSeconds(&now);
+}
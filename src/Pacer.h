@@ -0,0 +1,82 @@
+#ifndef _PACER_H_
+#define _PACER_H_
+
+#include "Utilities.h"
+#include "RunningStatistics.h"
+
+#define DEFAULT_BURST_SIZE      8          // packets , never less than a batch
+#define PACER_MAX_SLEEP_NANO    100000000  // 100ms , so the sender can still notice a stop
+#define PACER_INITIAL_SLACK     60000      // 60us , typical timer slack of a sleeping thread
+#define PACER_SLACK_GAIN        8.0        // EWMA weight (1/8) for the wakeup slack estimate
+#define PACER_MAX_SPIN_NANO     50000      // 50us , longer gaps are slept even when the wakeups run late
+#define PACER_LOOKAHEAD_NANO    2000000    // 2ms , how far ahead of the wire the kernel pacing may be fed
+
+#define PACING_USER             0          // userspace token bucket
+#define PACING_RATE             1          // SO_MAX_PACING_RATE , needs the fq qdisc
+#define PACING_TXTIME           2          // SO_TXTIME launch time per datagram , needs the fq or the etf qdisc
+
+//How late (ns) every departure left
+struct PacingStatistics
+{
+    RunningStatistics errors;
+
+    PacingStatistics();
+
+    void Reset();
+
+    void Push(double error);
+
+    // =======================================================================================================================================
+    // ================================================== Getters ============================================================================
+    // =======================================================================================================================================
+
+    double GetMeanError();
+
+    double GetErrorDeviation();
+
+    double GetMaxError();
+
+    static void CombineStatistics(PacingStatistics* stats1 , const PacingStatistics* stats2);
+};
+
+class Pacer
+{
+private:
+    //Token bucket kept as a virtual schedule (GCRA) : the next departure time
+    //and how far behind it we are allowed to fall before the credit is dropped.
+    double   bytesPerNano;
+    double   nextDeparture;
+    double   burstNano;
+    uint32_t burstBytes;
+
+public:
+    PacingStatistics statistics;
+
+    Pacer();
+
+    void Setup(uint64_t bandwidth , uint32_t _burstBytes);
+
+    void Start(uint64_t start);
+
+    //A new rate from now on , the schedule and the burst in bytes stay
+    void SetBandwidth(uint64_t bandwidth);
+
+    //The departure time of the next batch. The schedule is absolute , so a late departure is paid back
+    //by the next ones (back to back) instead of drifting the achieved rate. Only lateness beyond the burst is forgiven.
+    uint64_t GetNextDeparture(uint64_t now);
+
+    //Books "bytes" on the schedule , they leave "GetTransmissionTime(bytes)" before the next ones
+    void Commit(uint32_t bytes);
+
+    //The next departure is "gap" nanoseconds after this one (for schedules that are not a constant rate)
+    void Delay(double gap);
+
+    //Nothing leaves before "until" , and no credit is left from the time before it
+    void Hold(uint64_t until);
+
+    double GetTransmissionTime(uint32_t bytes);
+
+    static uint64_t Now();
+};
+
+#endif
@@ -0,0 +1,112 @@
+#include "PacketPool.h"
+
+#include <sys/mman.h>
+
+PacketPool::PacketPool()
+{
+    memory         = NULL;
+    memorySize     = 0;
+    pinned         = false;
+    usesHugePages  = false;
+
+    slots          = 0;
+    packetsPerSlot = 0;
+    packetSize     = 0;
+    packetStride   = 0;
+}
+
+PacketPool::~PacketPool()
+{
+    Release();
+}
+
+bool PacketPool::Setup(uint32_t _slots , uint32_t _packetsPerSlot , uint32_t _packetSize , bool hugePages , bool packed)
+{
+    Release();
+
+    slots          = _slots;
+    packetsPerSlot = _packetsPerSlot;
+    packetSize     = _packetSize;
+
+    //Unless packed , every packet starts on its own cache line so stamping one header never touches the line of another
+    if(packed)
+        packetStride = packetSize;
+    else
+        packetStride = ((packetSize + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE) * CACHE_LINE_SIZE;
+    memorySize   = (uint64_t)slots * packetsPerSlot * packetStride;
+
+    if(hugePages)
+    {
+        uint64_t hugeSize = ((memorySize + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE) * HUGE_PAGE_SIZE;
+
+        memory = (uint8_t*)mmap(NULL , hugeSize , PROT_READ | PROT_WRITE , MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB , -1 , 0);
+        if(memory != MAP_FAILED)
+        {
+            memorySize    = hugeSize;
+            usesHugePages = true;
+        }
+        else
+            fprintf(stderr, "[PACKET POOL ~ INFO] : no hugepages reserved , falling back to regular pages.\n");
+    }
+
+    if(!usesHugePages)
+    {
+        memory = (uint8_t*)mmap(NULL , memorySize , PROT_READ | PROT_WRITE , MAP_PRIVATE | MAP_ANONYMOUS , -1 , 0);
+        if(memory == MAP_FAILED)
+        {
+            memory = NULL;
+            perror("[PACKET POOL ~ ERROR]");
+            return false;
+        }
+
+        //Transparent hugepages are the next best thing
+        if(hugePages)
+            madvise(memory , memorySize , MADV_HUGEPAGE);
+    }
+
+    //The payload never changes , so fill it once (a pattern that a compressing link can not cheat on)
+    uint32_t pattern = 0x9e3779b9;
+    for(uint32_t slot = 0; slot < slots; slot++)
+    {
+        for(uint32_t packet = 0; packet < packetsPerSlot; packet++)
+        {
+            uint8_t* buffer = GetPacket(slot , packet);
+
+            for(uint32_t byte = 0; byte < packetSize; byte++)
+            {
+                pattern ^= pattern << 13;
+                pattern ^= pattern >> 17;
+                pattern ^= pattern << 5;
+
+                buffer[byte] = (uint8_t)pattern;
+            }
+        }
+    }
+
+    return true;
+}
+
+void PacketPool::Release()
+{
+    if(!memory)
+        return;
+
+    if(pinned)
+        munlock(memory , memorySize);
+
+    munmap(memory , memorySize);
+
+    memory        = NULL;
+    memorySize    = 0;
+    pinned        = false;
+    usesHugePages = false;
+}
+
+bool PacketPool::Pin()
+{
+    if(!memory || mlock(memory , memorySize))
+        return false;
+
+    pinned = true;
+    return true;
+}
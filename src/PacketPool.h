@@ -0,0 +1,74 @@
+#ifndef _PACKET_POOL_H_
+#define _PACKET_POOL_H_
+
+#include "Utilities.h"
+
+#include <endian.h>
+
+#define HUGE_PAGE_SIZE          (2 * 1024 * 1024)
+
+//Preallocated , cache aligned packets that every send backend stamps and sends from.
+//The payload is written once at setup , the hot path only patches the header :
+//
+//   | sequence number (64bit , big endian) | send time (seconds 32bit , nanoseconds 32bit , big endian) | payload ... |
+//
+class PacketPool
+{
+private:
+    uint8_t* memory;
+    uint64_t memorySize;
+    bool     pinned;
+
+    uint32_t slots;
+    uint32_t packetsPerSlot;
+    uint32_t packetSize;
+    uint32_t packetStride;
+
+public:
+    bool usesHugePages;
+
+    PacketPool();
+
+    ~PacketPool();
+
+    //"packed" puts the packets back to back instead of on their own cache lines (GSO wants one iovec per message)
+    bool Setup(uint32_t _slots , uint32_t _packetsPerSlot , uint32_t _packetSize , bool hugePages , bool packed);
+
+    void Release();
+
+    //Keeps the pages resident (MSG_ZEROCOPY pins them anyway)
+    bool Pin();
+
+    inline uint8_t* GetPacket(uint32_t slot , uint32_t packet)
+    {
+        return memory + ((((uint64_t)slot * packetsPerSlot) + packet) * packetStride);
+    }
+
+    // =======================================================================================================================================
+    // ================================================== Header Stamping ====================================================================
+    // =======================================================================================================================================
+
+    //The wire form of a send time , computed once and then copied into every packet of a batch
+    static inline uint64_t EncodeTime(Time* time)
+    {
+        uint32_t wire[2];
+
+        wire[0] = htobe32((uint32_t)time->tv_sec);
+        wire[1] = htobe32((uint32_t)time->tv_nsec);
+
+        uint64_t encoded;
+        memcpy(&encoded , wire , sizeof(uint64_t));
+
+        return encoded;
+    }
+
+    static inline void StampHeader(uint8_t* packet , uint64_t sequenceNumber , uint64_t encodedTime)
+    {
+        uint64_t wireSequenceNumber = htobe64(sequenceNumber);
+
+        memcpy(packet                    , &wireSequenceNumber , sizeof(uint64_t));
+        memcpy(packet + sizeof(uint64_t) , &encodedTime        , sizeof(uint64_t));
+    }
+};
+
+#endif
@@ -0,0 +1,53 @@
+#include "ReorderWindow.h"
+
+ReorderWindow::ReorderWindow()
+{
+    Reset();
+}
+
+void ReorderWindow::Reset()
+{
+    memset(received , 0 , sizeof(received));
+    memset(passedAt , 0 , sizeof(passedAt));
+
+    highest  = 0;
+    arrivals = 0;
+}
+
+uint8_t ReorderWindow::Push(uint64_t sequenceNumber , uint32_t* extent)
+{
+    uint32_t arrival = arrivals++;
+    uint32_t slot    = sequenceNumber & (REORDER_WINDOW - 1);
+
+    if(sequenceNumber > highest)
+    {
+        //The slots of the skipped sequence numbers are reused , whatever they held fell out of the window
+        uint64_t first = std::max(highest + 1 , (sequenceNumber >= REORDER_WINDOW) ? sequenceNumber - REORDER_WINDOW + 1 : 0);
+
+        for(uint64_t skipped = first; skipped < sequenceNumber; skipped++)
+        {
+            uint32_t skippedSlot = skipped & (REORDER_WINDOW - 1);
+
+            received[skippedSlot / 64] &= ~(1ULL << (skippedSlot % 64));
+            passedAt[skippedSlot] = arrival;
+        }
+
+        received[slot / 64] |= (1ULL << (slot % 64));
+        highest = sequenceNumber;
+
+        return REORDER_NEXT;
+    }
+
+    if(highest - sequenceNumber >= REORDER_WINDOW)
+        return REORDER_TOO_OLD;
+
+    if(received[slot / 64] & (1ULL << (slot % 64)))
+        return REORDER_DUPLICATE;
+
+    received[slot / 64] |= (1ULL << (slot % 64));
+
+    //The arrivals since the first packet with a higher sequence number
+    *extent = arrival - passedAt[slot];
+
+    return REORDER_LATE;
+}
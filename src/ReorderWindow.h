@@ -0,0 +1,41 @@
+#ifndef _REORDER_WINDOW_H_
+#define _REORDER_WINDOW_H_
+
+#include "Utilities.h"
+
+#define REORDER_WINDOW          1024    // sequence numbers behind the highest one (a power of two)
+#define REORDER_WINDOW_WORDS    (REORDER_WINDOW / 64)
+
+#define REORDER_NEXT            0       // higher than every sequence number so far
+#define REORDER_LATE            1       // came after a higher one (RFC 4737 reordered)
+#define REORDER_DUPLICATE       2
+#define REORDER_TOO_OLD         3       // behind the window , a late packet can not be told from a duplicate
+
+//The sequence numbers of a stream that arrived , over a window behind the highest one. A packet that fills
+//a hole was reordered , one whose bit is already set is a duplicate. Every skipped sequence number keeps the
+//arrival that passed over it , the reordering extent (RFC 4737 , 4.2.1) is how many arrivals ago that was.
+//O(1) per packet , a jump clears at most the window once.
+class ReorderWindow
+{
+private:
+    uint64_t received[REORDER_WINDOW_WORDS];
+    uint32_t passedAt[REORDER_WINDOW];
+
+    uint64_t highest;
+    uint32_t arrivals;
+
+public:
+    ReorderWindow();
+
+    void Reset();
+
+    //One of the REORDER_* , the extent is set for a REORDER_LATE packet
+    uint8_t Push(uint64_t sequenceNumber , uint32_t* extent);
+
+    inline uint64_t GetHighest()
+    {
+        return highest;
+    }
+};
+
+#endif
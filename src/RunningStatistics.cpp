@@ -0,0 +1,87 @@
+#include "RunningStatistics.h"
+
+#include <math.h>
+#include <algorithm>
+
+RunningStatistics::RunningStatistics()
+{
+    Reset();
+}
+
+void RunningStatistics::Reset()
+{
+    count = 0;
+    mean  = 0.0f;
+    m2    = 0.0f;
+    min   = 0.0f;
+    max   = 0.0f;
+}
+
+void RunningStatistics::Push(double value)
+{
+    double delta;
+
+    if(!count)
+        min = max = value;
+
+    count++;
+
+    delta = value - mean;
+    mean += delta / count;
+    m2   += delta * (value - mean);
+
+    min = std::min(min , value);
+    max = std::max(max , value);
+}
+
+// =======================================================================================================================================
+// ================================================== Getters ============================================================================
+// =======================================================================================================================================
+
+double RunningStatistics::GetMean()
+{
+    return mean;
+}
+
+double RunningStatistics::GetStandardDeviation()
+{
+    return count ? sqrt(std::max(m2 , 0.0) / count) : 0.0;
+}
+
+double RunningStatistics::GetSampleStandardDeviation()
+{
+    return (count > 1) ? sqrt(std::max(m2 , 0.0) / (count - 1)) : 0.0;
+}
+
+double RunningStatistics::GetMin()
+{
+    return min;
+}
+
+double RunningStatistics::GetMax()
+{
+    return max;
+}
+
+void RunningStatistics::Combine(RunningStatistics* stats1 , const RunningStatistics* stats2)
+{
+    //An empty one changes nothing , the min and max of it are not values of the series
+    if(!stats2->count)
+        return;
+
+    if(!stats1->count)
+    {
+        *stats1 = *stats2;
+        return;
+    }
+
+    uint64_t count = stats1->count + stats2->count;
+    double   delta = stats2->mean - stats1->mean;
+
+    stats1->m2   += stats2->m2 + (delta * delta * ((double)stats1->count * stats2->count)) / count;
+    stats1->mean += delta * ((double)stats2->count / count);
+    stats1->min   = std::min(stats1->min , stats2->min);
+    stats1->max   = std::max(stats1->max , stats2->max);
+
+    stats1->count = count;
+}
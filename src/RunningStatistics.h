@@ -0,0 +1,50 @@
+#ifndef _RUNNING_STATISTICS_H_
+#define _RUNNING_STATISTICS_H_
+
+#include <cstdint>
+
+//The count , mean , M2 (the sum of the squared distances from the mean) , min and max of a series , pushed one
+//value at a time (Welford). Two of them combine exactly (the parallel Welford) , in whatever order and grouping ,
+//so the series of any number of streams and shards merge into the one of all of them.
+struct RunningStatistics
+{
+    uint64_t count;
+    double   mean;
+    double   m2;
+    double   min;
+    double   max;
+
+    RunningStatistics();
+
+    void Reset();
+
+    void Push(double value);
+
+    // =======================================================================================================================================
+    // ================================================== Getters ============================================================================
+    // =======================================================================================================================================
+
+    double GetMean();
+
+    //Of the whole series (M2 / count) , and of it as a sample (M2 / (count - 1))
+    double GetStandardDeviation();
+
+    double GetSampleStandardDeviation();
+
+    double GetMin();
+
+    double GetMax();
+
+    static void Combine(RunningStatistics* stats1 , const RunningStatistics* stats2);
+};
+
+//Combines "size" items into the first one , pairwise as a tree. Every value goes through log2(size) merges
+//instead of up to "size" , so the rounding errors of hundreds of streams stay as small as the ones of a few.
+template <typename T> void ReduceTree(T* items , uint32_t size)
+{
+    for(uint32_t step = 1; step < size; step *= 2)
+        for(uint32_t item = 0; item + step < size; item += 2 * step)
+            T::Combine(&items[item] , &items[item + step]);
+}
+
+#endif
@@ -0,0 +1,571 @@
+#include "SenderWorker.h"
+
+#include <errno.h>
+
+// =======================================================================================================================================
+// ================================================== Client Stream ======================================================================
+// =======================================================================================================================================
+
+ClientStreamParams::ClientStreamParams()
+{
+    socketId       = -1;
+    port           = 0;
+    memset(&serverToSendData , 0 , sizeof(struct sockaddr_in));
+
+    totalBytesSend = 0;
+    udpSeqNumber   = 0;
+    totalSyscalls  = 0;
+
+    udpPacketSize  = DEFAULT_UDP_PACKET_SIZE;
+    batchSize      = DEFAULT_BATCH_SIZE;
+    gsoSegments    = 0;
+
+    memset(&startTime , 0 , sizeof(Time));
+    memset(&endTime   , 0 , sizeof(Time));
+
+    pacingMode     = PACING_USER;
+    txTimeOffset   = 0;
+
+    useZeroCopy    = 0;
+    zeroCopySlot   = 0;
+    zeroCopy       = NULL;
+    pool           = NULL;
+}
+
+ClientStreamParams::~ClientStreamParams()
+{
+    if(zeroCopy)
+        delete zeroCopy;
+
+    if(pool)
+        delete pool;
+}
+
+// =======================================================================================================================================
+// ================================================== Sender Worker ======================================================================
+// =======================================================================================================================================
+
+SenderWorker::SenderWorker(double _durationInSeconds , uint8_t _useHugePages , uint8_t _useIoUring , TrafficProfile* _profile)
+{
+    durationInSeconds = _durationInSeconds;
+    useHugePages      = _useHugePages;
+    useIoUring        = _useIoUring;
+    ring              = NULL;
+    maxMessages       = 1;
+    profile           = (_profile && !_profile->IsEmpty()) ? _profile : NULL;
+    random.seed(std::random_device()());
+
+    epoch       = 0;
+    wakeupSlack = PACER_INITIAL_SLACK;
+    stop        = false;
+    cpuTime     = 0.0f;
+
+    totalSyscalls = 0;
+}
+
+SenderWorker::~SenderWorker()
+{
+    if(ring)
+        delete ring;
+}
+
+void SenderWorker::AddStream(ClientStreamParams* stream)
+{
+    streams.push_back(stream);
+}
+
+void SenderWorker::Stop()
+{
+    stop = true;
+}
+
+bool SenderWorker::SetupBuffers()
+{
+    uint32_t maxBatch    = 1;
+    uint32_t batches     = 1;
+    uint32_t packetSize  = DEFAULT_UDP_PACKET_SIZE;
+    bool     copies      = false;
+    bool     packed      = false;
+
+    for(auto stream : streams)
+    {
+        //Without GSO every datagram is a message , with GSO a message gathers "gsoSegments" datagrams that the kernel splits again
+        uint32_t segments       = stream->gsoSegments ? stream->gsoSegments : 1;
+        uint32_t streamMessages = (stream->batchSize + segments - 1) / segments;
+
+        maxMessages = std::max(maxMessages , streamMessages);
+
+        if(stream->useZeroCopy)
+        {
+            //The batches of a zerocopy stream rotate over its own ring of pinned slots , until the kernel releases them.
+            //Allocated here , so the pages are first touched by the thread that uses them.
+            stream->pool     = new PacketPool();
+            stream->zeroCopy = new ZeroCopy();
+
+            if(!stream->pool->Setup(ZEROCOPY_RING_SLOTS , stream->batchSize , stream->udpPacketSize , useHugePages , segments > 1))
+                return false;
+
+            if(!stream->pool->Pin())
+                perror("[UDP CLIENT ~ INFO] : unable to pin the zerocopy ring");
+
+            stream->zeroCopy->Setup(stream->socketId , ZEROCOPY_RING_SLOTS , streamMessages);
+            continue;
+        }
+
+        //A GSO message is a single iovec over back to back datagrams (MSG_ZEROCOPY can not take one page fragment per datagram)
+        copies     = true;
+        packed     = packed || (segments > 1);
+        maxBatch   = std::max(maxBatch , stream->batchSize);
+        packetSize = stream->udpPacketSize;
+    }
+
+    if(useIoUring)
+    {
+        //Room for the messages of every batch that a single submission may carry
+        ring = new IoUring();
+
+        if(ring->Setup(IO_URING_MAX_BATCHES * maxMessages))
+            batches = IO_URING_MAX_BATCHES;
+        else
+        {
+            perror("[UDP CLIENT ~ INFO] : io_uring , falling back to sendmmsg");
+            delete ring;
+            ring = NULL;
+        }
+    }
+
+    //The batches in flight together never share a slot of the copy pool
+    if(copies && !pool.Setup(batches , maxBatch , packetSize , useHugePages , packed))
+        return false;
+
+    iovecs.resize(batches * maxMessages);
+    messages.resize(batches * maxMessages);
+    results.resize(batches * maxMessages);
+    controls.assign(batches * maxMessages * CMSG_SPACE(sizeof(uint64_t)) , 0);
+
+    for(uint32_t message = 0; message < batches * maxMessages; message++)
+    {
+        struct msghdr   header;
+        struct cmsghdr* control;
+
+        memset(&messages[message], 0 , sizeof(struct mmsghdr));
+        messages[message].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+        messages[message].msg_hdr.msg_iovlen  = 1;
+
+        //The SCM_TXTIME header never changes , only the launch time it carries
+        memset(&header , 0 , sizeof(struct msghdr));
+        header.msg_control    = controls.data() + (message * CMSG_SPACE(sizeof(uint64_t)));
+        header.msg_controllen = CMSG_SPACE(sizeof(uint64_t));
+
+        control             = CMSG_FIRSTHDR(&header);
+        control->cmsg_level = SOL_SOCKET;
+        control->cmsg_type  = SCM_TXTIME;
+        control->cmsg_len   = CMSG_LEN(sizeof(uint64_t));
+    }
+
+    return true;
+}
+
+uint64_t SenderWorker::GetTick(uint64_t time)
+{
+    return (time > epoch) ? (time - epoch) / TIMING_WHEEL_TICK_NANO : 0;
+}
+
+bool SenderWorker::ApplyProfile(uint32_t index , uint64_t departure , uint64_t lead)
+{
+    ClientStreamParams* stream = streams[index];
+    uint64_t resume;
+    uint64_t bandwidth = profile->GetBandwidth(departure - epoch , &resume);
+
+    if(!bandwidth)
+    {
+        //Off , the next batch leaves when the profile sends again
+        stream->pacer.Hold(epoch + resume);
+        wheel.Schedule(index , GetTick(epoch + resume - lead));
+        return false;
+    }
+
+    stream->pacer.SetBandwidth(bandwidth);
+    return true;
+}
+
+uint32_t SenderWorker::PrepareBatch(ClientStreamParams* stream , uint64_t launchTime , uint32_t slot , uint32_t firstMessage)
+{
+    PacketPool*     source           = stream->pool ? stream->pool : &pool;
+    uint32_t        segments         = stream->gsoSegments ? stream->gsoSegments : 1;
+    uint32_t        packets          = stream->batchSize;
+    uint32_t        numberOfMessages = (packets + segments - 1) / segments;
+    struct mmsghdr* batch            = &messages[firstMessage];
+    uint64_t        encodedTime;
+    Time            sendTime;
+
+    //A zerocopy stream rotates over its own ring
+    if(stream->pool)
+        slot = stream->zeroCopySlot;
+
+    //Never write into a slot that the kernel has not released yet
+    if(stream->useZeroCopy && !stream->zeroCopy->WaitForSlot(slot))
+    {
+        perror("[UDP CLIENT ~ ERROR] : while waiting for the zerocopy completions");
+        return 0;
+    }
+
+    for(uint32_t message = 0; message < numberOfMessages; message++)
+    {
+        struct msghdr* header      = &batch[message].msg_hdr;
+        uint32_t       firstPacket = message * segments;
+        struct iovec*  iovec       = &iovecs[firstMessage + message];
+
+        iovec->iov_base = source->GetPacket(slot , firstPacket);
+        iovec->iov_len  = std::min(segments , packets - firstPacket) * stream->udpPacketSize;
+
+        header->msg_name       = &stream->serverToSendData;
+        header->msg_iov        = iovec;
+        header->msg_control    = launchTime ? controls.data() + ((firstMessage + message) * CMSG_SPACE(sizeof(uint64_t))) : NULL;
+        header->msg_controllen = launchTime ? CMSG_SPACE(sizeof(uint64_t)) : 0;
+    }
+
+    //One clock read for the whole batch , every datagram still gets its own sequence number
+    SystemClock::GetSystemTime(&sendTime);
+    encodedTime = PacketPool::EncodeTime(&sendTime);
+
+    for(uint32_t packet = 0; packet < packets; packet++)
+    {
+        uint8_t* udpBuffer = source->GetPacket(slot , packet);
+
+        if(launchTime)
+        {
+            //The datagram leaves at its launch time , so that is its send time too
+            uint64_t packetLaunchTime = launchTime + (uint64_t)stream->pacer.GetTransmissionTime(packet * stream->udpPacketSize);
+            uint64_t kernelLaunchTime = packetLaunchTime + stream->txTimeOffset;
+            Time     packetTime       = SystemClock::GetTimeFromNanoSeconds(packetLaunchTime);
+
+            encodedTime = PacketPool::EncodeTime(&packetTime);
+
+            //A GSO message leaves as a whole , at the launch time of its first segment
+            if(!(packet % segments))
+                memcpy(CMSG_DATA(CMSG_FIRSTHDR(&batch[packet / segments].msg_hdr)), &kernelLaunchTime, sizeof(uint64_t));
+        }
+
+        PacketPool::StampHeader(udpBuffer , stream->udpSeqNumber + packet + 1 , encodedTime);
+    }
+
+    return numberOfMessages;
+}
+
+uint32_t SenderWorker::FinishBatch(ClientStreamParams* stream , uint32_t sent)
+{
+    uint32_t segments = stream->gsoSegments ? stream->gsoSegments : 1;
+    uint32_t packets  = stream->batchSize;
+
+    if(stream->useZeroCopy && sent)
+    {
+        stream->zeroCopy->Submitted(stream->zeroCopySlot , sent);
+        stream->zeroCopySlot = (stream->zeroCopySlot + 1) % ZEROCOPY_RING_SLOTS;
+    }
+
+    //Only what left counts , the rest is stamped again with the same sequence numbers next time
+    packets = std::min(sent * segments , packets);
+    stream->udpSeqNumber += packets;
+
+    return packets;
+}
+
+uint32_t SenderWorker::UDPSend(ClientStreamParams* stream , uint64_t launchTime)
+{
+    uint32_t numberOfMessages = PrepareBatch(stream , launchTime , 0 , 0);
+    uint32_t sent             = 0;
+    int      sendFlags        = MSG_DONTWAIT | (stream->useZeroCopy ? MSG_ZEROCOPY : 0);
+
+    if(!numberOfMessages)
+        return 0;
+
+    //The sends never block , a full socket buffer must not stall the other streams of the worker
+    if(numberOfMessages == 1 && !launchTime)
+    {
+        stream->totalSyscalls++;
+
+        int64_t bytesSend = sendmsg(stream->socketId , &messages[0].msg_hdr , sendFlags);
+        if(bytesSend > 0)
+        {
+            stream->totalBytesSend += bytesSend;
+            sent = 1;
+        }
+        else if(errno != EAGAIN && errno != EWOULDBLOCK)
+            perror("[UDP CLIENT ~ ERROR] : Something went wrong while trying to send data");
+    }
+    else
+    {
+        //sendmmsg may stop early , so keep going until the whole batch is out
+        while(sent < numberOfMessages)
+        {
+            stream->totalSyscalls++;
+
+            int result = sendmmsg(stream->socketId , &messages[sent] , numberOfMessages - sent , sendFlags);
+            if(result <= 0)
+            {
+                if(errno != EAGAIN && errno != EWOULDBLOCK)
+                    perror("[UDP CLIENT ~ ERROR] : Something went wrong while trying to send data");
+                break;
+            }
+
+            for(int message = 0; message < result; message++)
+                stream->totalBytesSend += messages[sent + message].msg_len;
+            sent += result;
+        }
+    }
+
+    return FinishBatch(stream , sent);
+}
+
+void SenderWorker::QueueBatch(uint32_t index , uint64_t departure , uint64_t now , uint64_t launchTime)
+{
+    ClientStreamParams* stream = streams[index];
+    PendingBatch        batch;
+    int                 sendFlags = MSG_DONTWAIT | (stream->useZeroCopy ? MSG_ZEROCOPY : 0);
+
+    batch.index            = index;
+    batch.departure        = departure;
+    batch.now              = now;
+    batch.slot             = pending.size();
+    batch.firstMessage     = pending.empty() ? 0 : pending.back().firstMessage + pending.back().numberOfMessages;
+    batch.numberOfMessages = PrepareBatch(stream , launchTime , batch.slot , batch.firstMessage);
+
+    if(!batch.numberOfMessages)
+    {
+        Sent(index , departure , now , 0);
+        return;
+    }
+
+    for(uint32_t message = 0; message < batch.numberOfMessages; message++)
+    {
+        //The ring holds every message of IO_URING_MAX_BATCHES batches , so there is always an entry
+        struct io_uring_sqe* sqe = ring->GetSqe();
+
+        IoUring::PrepareSendMsg(sqe , stream->socketId , &messages[batch.firstMessage + message].msg_hdr , sendFlags , batch.firstMessage + message);
+
+        //A batch is a chain , a message that does not leave cancels the ones behind it (no holes in the sequence numbers)
+        if(message + 1 < batch.numberOfMessages)
+            sqe->flags |= IOSQE_IO_LINK;
+    }
+
+    pending.push_back(batch);
+
+    if(pending.size() == IO_URING_MAX_BATCHES)
+        FlushBatches();
+}
+
+void SenderWorker::FlushBatches()
+{
+    uint32_t completed = 0;
+    uint32_t total;
+    int      result;
+
+    if(pending.empty())
+        return;
+
+    total = pending.back().firstMessage + pending.back().numberOfMessages;
+    std::fill(results.begin() , results.begin() + total , -ECANCELED);
+
+    //Every queued batch (of every stream) goes out with a single system call
+    result = ring->Submit(total);
+
+    while(true)
+    {
+        for(struct io_uring_cqe* cqe = ring->PeekCqe(); cqe; cqe = ring->PeekCqe())
+        {
+            results[cqe->user_data] = cqe->res;
+            ring->SeenCqe();
+            completed++;
+        }
+
+        if(completed >= total)
+            break;
+
+        if(result < 0 && errno != EINTR)
+        {
+            perror("[UDP CLIENT ~ ERROR] : io_uring_enter");
+            break;
+        }
+
+        result = ring->Submit(total - completed);
+    }
+
+    for(auto& batch : pending)
+    {
+        ClientStreamParams* stream = streams[batch.index];
+        int32_t*            batchResults = &results[batch.firstMessage];
+        uint32_t            sent = 0;
+
+        while(sent < batch.numberOfMessages && batchResults[sent] > 0)
+            stream->totalBytesSend += batchResults[sent++];
+
+        if(sent < batch.numberOfMessages && batchResults[sent] != -EAGAIN && batchResults[sent] != -ECANCELED)
+        {
+            errno = -batchResults[sent];
+            perror("[UDP CLIENT ~ ERROR] : Something went wrong while trying to send data");
+        }
+
+        Sent(batch.index , batch.departure , batch.now , FinishBatch(stream , sent));
+    }
+
+    pending.clear();
+}
+
+void SenderWorker::Sent(uint32_t index , uint64_t departure , uint64_t now , uint32_t sent)
+{
+    ClientStreamParams* stream = streams[index];
+    uint64_t lead = (stream->pacingMode == PACING_USER) ? 0 : PACER_LOOKAHEAD_NANO;
+
+    if(!sent)
+    {
+        //The socket buffer is full , come back a little later
+        wheel.Schedule(index , GetTick(now + SENDER_RETRY_NANO));
+        return;
+    }
+
+    if(stream->pacingMode == PACING_USER)
+        stream->pacer.statistics.Push(now - departure);
+
+    if(profile)
+        stream->pacer.Delay(profile->GetGap(departure - epoch , sent * stream->udpPacketSize * 8 , random));
+    else
+        stream->pacer.Commit(sent * stream->udpPacketSize);
+
+    wheel.Schedule(index , GetTick(stream->pacer.GetNextDeparture(now) - lead));
+}
+
+void SenderWorker::Sleep(uint64_t until)
+{
+    uint64_t now = Pacer::Now();
+    double   wait;
+
+    //Close enough , spinning through the wheel is more accurate than any sleep
+    if(until <= now + std::min<double>(wakeupSlack , PACER_MAX_SPIN_NANO))
+        return;
+
+    //Sleep for the bulk of the gap , minus what the scheduler usually adds on top. Never less than half of it ,
+    //a worker with many streams has short gaps and must keep sleeping (and learning) rather than spin.
+    wait = until - now;
+
+    double sleepTime = wait - std::min(wakeupSlack , wait / 2.0);
+    double sleepEnd  = now + sleepTime;
+
+    std::this_thread::sleep_for(std::chrono::nanoseconds((uint64_t)sleepTime));
+
+    //... and learn from how late we actually woke up
+    wakeupSlack += (Pacer::Now() - sleepEnd - wakeupSlack) / PACER_SLACK_GAIN;
+    if(wakeupSlack < 0)
+        wakeupSlack = 0;
+}
+
+void SenderWorker::Run(uint64_t start)
+{
+    std::vector<uint32_t> expired;
+    uint64_t stopTime = 0;
+    uint64_t now;
+    Time     startTime;
+    Time     endTime;
+    Time     cpu;
+
+    if(!SetupBuffers())
+        return;
+
+    startTime = SystemClock::GetTimeFromNanoSeconds(start);
+    epoch     = start;
+    if(durationInSeconds)
+        stopTime = epoch + (uint64_t)(durationInSeconds * ONE_SECOND_TO_NANO);
+
+    wheel.Setup(streams.size() , 0);
+
+    for(uint32_t index = 0; index < streams.size(); index++)
+    {
+        ClientStreamParams* stream = streams[index];
+
+        //Spread the first departures over the gap between two batches , so the streams do not all burst together
+        double   gap       = stream->pacer.GetTransmissionTime(stream->batchSize * stream->udpPacketSize);
+        uint64_t departure = epoch + (uint64_t)((gap * index) / streams.size());
+
+        stream->startTime = startTime;
+        stream->endTime   = startTime;
+        stream->pacer.Start(departure);
+
+        wheel.Schedule(index , GetTick(departure));
+    }
+
+    while(!stop)
+    {
+        now = Pacer::Now();
+        if(stopTime && now >= stopTime)
+            break;
+
+        wheel.Advance(GetTick(now) , &expired);
+
+        for(auto index : expired)
+        {
+            ClientStreamParams* stream = streams[index];
+
+            //The kernel pacing is fed a few ms ahead of the wire , the userspace pacing sends on the departure itself
+            uint64_t lead = (stream->pacingMode == PACING_USER) ? 0 : PACER_LOOKAHEAD_NANO;
+            uint64_t departure;
+            uint64_t launchTime;
+
+            now       = Pacer::Now();
+            departure = stream->pacer.GetNextDeparture(now);
+
+            if(departure > now + lead + TIMING_WHEEL_TICK_NANO)
+            {
+                wheel.Schedule(index , GetTick(departure - lead));
+                continue;
+            }
+
+            departure = std::max(departure , epoch);
+            if(profile && !ApplyProfile(index , departure , lead))
+                continue;
+
+            //The wheel works in whole ticks , spin for what is left of this one
+            if(stream->pacingMode == PACING_USER)
+                while((now = Pacer::Now()) < departure);
+
+            launchTime = (stream->pacingMode == PACING_TXTIME) ? std::max(departure , now) : 0;
+
+            //With io_uring the batches due together leave together , once every expired stream is queued
+            if(ring)
+                QueueBatch(index , departure , now , launchTime);
+            else
+                Sent(index , departure , now , UDPSend(stream , launchTime));
+        }
+        expired.clear();
+
+        if(ring)
+            FlushBatches();
+
+        //Nothing to do until the next stream is due (or the wheel cascades)
+        uint64_t ticks  = wheel.TicksUntilNextEvent();
+        uint64_t wakeup = now + PACER_MAX_SLEEP_NANO;
+
+        if(ticks != TIMING_WHEEL_NEVER)
+            wakeup = std::min(wakeup , epoch + ((wheel.GetCurrentTick() + ticks) * TIMING_WHEEL_TICK_NANO));
+        if(stopTime)
+            wakeup = std::min(wakeup , stopTime);
+
+        Sleep(wakeup);
+    }
+
+    SystemClock::GetSystemTime(&endTime);
+
+    for(auto stream : streams)
+    {
+        stream->endTime = endTime;
+
+        if(stream->useZeroCopy && stream->zeroCopy)
+            stream->zeroCopy->Reap();
+    }
+
+    if(ring)
+        totalSyscalls += ring->totalSyscalls;
+
+    //What the streams cost in CPU , for the copy vs zerocopy comparison
+    SystemClock::GetThreadCpuTime(&cpu);
+    cpuTime = SystemClock::GetTimeInSeconds(&cpu);
+}
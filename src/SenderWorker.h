@@ -0,0 +1,144 @@
+#ifndef _SENDER_WORKER_H_
+#define _SENDER_WORKER_H_
+
+#include "Utilities.h"
+#include "Pacer.h"
+#include "ZeroCopy.h"
+#include "PacketPool.h"
+#include "TimingWheel.h"
+#include "TrafficProfile.h"
+#include "IoUring.h"
+
+#include <atomic>
+
+#define DEFAULT_SENDER_THREADS  0          // one per core , never more than the streams
+#define SENDER_RETRY_NANO       50000      // 50us , how long a stream with a full socket buffer backs off
+
+//Everything a stream needs between two of its batches. The buffers belong to the worker that
+//sends it , so a stream stays small enough to have hundreds of thousands of them.
+struct ClientStreamParams
+{
+    int socketId;
+    uint16_t port;
+    struct sockaddr_in serverToSendData;
+
+    int64_t  totalBytesSend;
+
+    uint64_t udpSeqNumber;
+    uint64_t totalSyscalls;
+
+    uint32_t udpPacketSize;
+    uint32_t batchSize;
+    uint32_t gsoSegments;
+
+    Time startTime;
+    Time endTime;
+
+    Pacer   pacer;
+    uint8_t pacingMode;
+    int64_t txTimeOffset;
+
+    //Only for MSG_ZEROCOPY streams , the kernel keeps reading their batches after the send returns
+    uint8_t     useZeroCopy;
+    uint32_t    zeroCopySlot;
+    ZeroCopy*   zeroCopy;
+    PacketPool* pool;
+
+    ClientStreamParams();
+
+    ~ClientStreamParams();
+};
+
+//A batch queued on the io_uring , sent with the batches of the other streams due at the same time
+struct PendingBatch
+{
+    uint32_t index;
+    uint64_t departure;
+    uint64_t now;
+    uint32_t slot;
+    uint32_t firstMessage;
+    uint32_t numberOfMessages;
+};
+
+//Sends any number of paced streams from a single thread. A hierarchical timing wheel
+//holds every stream until its next departure , so an idle stream costs no wakeups.
+class SenderWorker
+{
+private:
+    std::vector<ClientStreamParams*> streams;
+    TimingWheel wheel;
+
+    //Shared by every stream that copies its datagrams , the kernel is done with them once the send returns
+    PacketPool pool;
+    uint8_t    useHugePages;
+
+    std::vector<struct iovec>   iovecs;
+    std::vector<struct mmsghdr> messages;
+    std::vector<uint8_t>        controls;
+    uint32_t                    maxMessages;
+
+    //io_uring backend , the copy pool then has a slot for every batch in flight
+    uint8_t      useIoUring;
+    IoUring*     ring;
+    std::vector<PendingBatch> pending;
+    std::vector<int32_t>      results;
+
+    double   durationInSeconds;
+    uint64_t epoch;
+
+    //Shared by every worker , read only
+    TrafficProfile* profile;
+    std::mt19937_64 random;
+
+    //How late (in nanoseconds) a sleep returns , corrected after every wakeup
+    double   wakeupSlack;
+
+    //Set by the client thread (or the SIGINT handler) while the worker runs
+    std::atomic<bool> stop;
+
+    bool SetupBuffers();
+
+    uint64_t GetTick(uint64_t time);
+
+    //Sets the rate of the batch that leaves at "departure". False if the profile is off , the stream is then put back on the wheel.
+    bool ApplyProfile(uint32_t index , uint64_t departure , uint64_t lead);
+
+    //Stamps a batch of "stream" into the messages from "firstMessage" on , launchTime == 0 : leave now ,
+    //otherwise the kernel holds the batch until its launch time. Returns the number of messages.
+    uint32_t PrepareBatch(ClientStreamParams* stream , uint64_t launchTime , uint32_t slot , uint32_t firstMessage);
+
+    //Accounts for the "sent" messages of a batch , returns how many datagrams went out
+    uint32_t FinishBatch(ClientStreamParams* stream , uint32_t sent);
+
+    //Sends a batch of "stream" right away. Returns how many datagrams went out.
+    uint32_t UDPSend(ClientStreamParams* stream , uint64_t launchTime);
+
+    //Queues a batch on the io_uring , FlushBatches sends every queued batch with a single system call
+    void QueueBatch(uint32_t index , uint64_t departure , uint64_t now , uint64_t launchTime);
+
+    void FlushBatches();
+
+    //Paces (or reschedules) the stream once its batch went out
+    void Sent(uint32_t index , uint64_t departure , uint64_t now , uint32_t sent);
+
+    void Sleep(uint64_t until);
+
+public:
+    double   cpuTime;
+
+    //System calls that no single stream owns (an io_uring_enter covers many streams)
+    uint64_t totalSyscalls;
+
+    SenderWorker(double _durationInSeconds , uint8_t _useHugePages , uint8_t _useIoUring , TrafficProfile* _profile);
+
+    ~SenderWorker();
+
+    void AddStream(ClientStreamParams* stream);
+
+    //Every worker starts its schedule (and the profile) at the same "start"
+    void Run(uint64_t start);
+
+    void Stop();
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef _SEQ_LOCK_H_
+#define _SEQ_LOCK_H_
+
+#include "Utilities.h"
+
+#include <atomic>
+
+//A value that a single thread writes and any other thread reads whole. The writer never waits , a reader
+//copies the value again whenever a write went on meanwhile (the sequence was odd , or it moved).
+//Only for values that can be copied with memcpy.
+template <typename T> class SeqLock
+{
+private:
+    std::atomic<uint32_t> sequence;
+    T value;
+
+public:
+    SeqLock() : sequence(0) {}
+
+    //The owner thread only
+    void Write(const T& _value)
+    {
+        uint32_t current = sequence.load(std::memory_order_relaxed);
+
+        sequence.store(current + 1 , std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        memcpy(&value , &_value , sizeof(T));
+
+        sequence.store(current + 2 , std::memory_order_release);
+    }
+
+    void Read(T* _value) const
+    {
+        uint32_t before;
+        uint32_t after;
+
+        do
+        {
+            before = sequence.load(std::memory_order_acquire);
+
+            memcpy(_value , &value , sizeof(T));
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence.load(std::memory_order_relaxed);
+        }while((before & 1) || before != after);
+    }
+};
+
+#endif
@@ -1,6 +1,10 @@
 #include "Server.h"
+#include "SocketOptions.h"
 
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <future>
 
 // ======================================================================================================================================= 
 // ================================================== Constructors ======================================================================= 
@@ -48,11 +52,32 @@ void Server::Setup()
 
     tcpbuffer = new uint8_t[NERF_PACKET_SIZE];
 
-    measurements = new Measurements();
+    measurements   = new Measurements();
+    latency        = new LatencyHistogram();
+    wakeLatency[0] = new LatencyHistogram();
+    wakeLatency[1] = new LatencyHistogram();
 
     printInFile               = DEFAULT_PRINT_IN_FILE;
     printResultAccordingTime  = 0;
     printResultsInterval      = 0.0f;
+    useIoUring                = 0;
+    recvBatchSize             = DEFAULT_BATCH_SIZE;
+    useGro                    = 0;
+    rxTimestamps              = RX_TIMESTAMP_USER;
+    numberOfReceiverThreads   = DEFAULT_RECEIVER_THREADS;
+    numberOfShards            = DEFAULT_SHARDS;
+    shardByCpu                = false;
+    busyPollNano              = DEFAULT_BUSY_POLL;
+    socketBufferCap           = DEFAULT_SOCKET_BUFFER_CAP;
+    intervalNano              = DEFAULT_INTERVAL_BUCKET * 1000000ULL;
+    retention                 = DEFAULT_RETENTION;
+    intervalEpoch             = 0;
+
+    serverReportInterval   = 0;
+    clientReportInterval   = 0;
+    clientReportLocalDrops = 0;
+    ewmaInterval           = 0;
+    ewmaThroughtput        = 0.0;
 
     stopRunning = false;
 
@@ -71,20 +96,34 @@ void Server::Reset()
     for(auto param : totalParams)
     {
         delete param->measurements;
+        delete param->latency;
+        delete param->wakeLatency[0];
+        delete param->wakeLatency[1];
         delete param;
     }    
     totalParams.clear();
     
-    for(auto stream : openStreams)
-        delete stream;
-    openStreams.clear();
+    for(auto receiver : receivers)
+    {
+        delete receiver->thread;
+        delete receiver;
+    }
+    receivers.clear();
 
     openPorts.clear();
     bindUdpAddresses.clear();
+
+    phases.clear();
+    phasesStartTime = 0;
     
     startPrintData  = false;
 
     measurements->Reset();
+    latency->Reset();
+    wakeLatency[0]->Reset();
+    wakeLatency[1]->Reset();
+    clockSync.Reset();
+    skewEstimator.Reset();
 
     //internal state
     udpPacketSize           = DEFAULT_UDP_PACKET_SIZE;
@@ -100,11 +139,7 @@ void Server::Reset()
 
     memset(tcpbuffer , 0 , NERF_PACKET_SIZE);
 
-    maxFd = -1;
-    
     isClientStop    = false;
-
-    FD_ZERO(&readDescriptors);
 }
 
 void Server::CleanUp()
@@ -122,13 +157,19 @@ void Server::CleanUp()
     for(auto param : totalParams)
     {
         delete param->measurements;
+        delete param->latency;
+        delete param->wakeLatency[0];
+        delete param->wakeLatency[1];
         delete param;
     }    
     totalParams.clear();
     
-    for(auto stream : openStreams)
-        delete stream;
-    openStreams.clear();
+    for(auto receiver : receivers)
+    {
+        delete receiver->thread;
+        delete receiver;
+    }
+    receivers.clear();
 
     openSockets.clear();
     openPorts.clear();
@@ -139,12 +180,29 @@ void Server::CleanUp()
 
     if(measurements)
         delete measurements;
+    if(latency)
+        delete latency;
+    if(wakeLatency[0])
+        delete wakeLatency[0];
+    if(wakeLatency[1])
+        delete wakeLatency[1];
 
-    FD_ZERO(&readDescriptors);
+    RestoreHardwareRxTimestamps();
 
     fclose(resultsFile);
 }
 
+void Server::RestoreHardwareRxTimestamps()
+{
+    if(hwStampInterface.empty())
+        return;
+
+    if(!SocketOptions::RestoreHardwareRxTimestamps(hwStampInterface , &hwStampConfig))
+        fprintf(stderr, "[TCP SERVER ~ INFO] : unable to put back the stamps of %s (%s).\n", hwStampInterface.c_str(), strerror(errno));
+
+    hwStampInterface.clear();
+}
+
 void Server::SetVariables(uint8_t _printInFile, 
                           std::string _resultsFileName,
                           uint8_t _printResultAccordingTime,
@@ -170,10 +228,74 @@ void Server::SetVariables(uint8_t _printInFile,
     } 
 }
 
+void Server::SetAffinity(const Affinity& _affinity)
+{
+    affinity = _affinity;
+}
+
+void Server::SetIoUring(uint8_t _useIoUring)
+{
+    useIoUring = _useIoUring;
+}
+
+void Server::SetRecvBatchSize(uint32_t _recvBatchSize)
+{
+    recvBatchSize = std::max<uint32_t>(_recvBatchSize , 1);
+}
+
+void Server::SetGro(uint8_t _useGro)
+{
+    useGro = _useGro;
+}
+
+void Server::SetRxTimestamps(uint8_t _rxTimestamps)
+{
+    rxTimestamps = _rxTimestamps;
+}
+
+void Server::SetReceiverThreads(uint32_t _numberOfReceiverThreads)
+{
+    numberOfReceiverThreads = _numberOfReceiverThreads;
+}
+
+void Server::SetShards(uint16_t _numberOfShards , bool _shardByCpu)
+{
+    numberOfShards = std::max<uint16_t>(_numberOfShards , 1);
+    shardByCpu     = _shardByCpu;
+}
+
+void Server::SetIntervals(uint32_t _intervalMilli , uint32_t _retention)
+{
+    intervalNano = _intervalMilli * 1000000ULL;
+    retention    = std::min<uint64_t>(_retention , std::max<uint64_t>((MAX_INTERVAL_BUCKETS * intervalNano) / ONE_SECOND_TO_NANO , 1));
+}
+
+void Server::SetHeatmap(std::string _heatmapFileName)
+{
+    heatmapFileName = _heatmapFileName;
+}
+
+void Server::SetSocketBufferCap(uint32_t _socketBufferCap)
+{
+    socketBufferCap = _socketBufferCap;
+}
+
+void Server::SetBusyPoll(uint64_t _busyPollNano)
+{
+    busyPollNano = _busyPollNano;
+
+    if(busyPollNano && !affinity.PinsStreams())
+        fprintf(stderr, "[UDP SERVER ~ INFO] : busy polling without --affinity , the spinning receivers share their cores with everything else.\n");
+}
+
 void Server::StopRunning()      
 { 
     stopRunning = true;
 
+    //Async signal safe , the threads of a running test return right away
+    StopReceivers();
+    controlLoop.Stop();
+
     CleanUp();
 };
 
@@ -224,6 +346,12 @@ ServerStreamParams* Server::CreateUdpServer(uint16_t portNo)
         exit(0);
     }
 
+    if(numberOfShards > 1 && !SocketOptions::SetReusePort(socketId))
+    {
+        perror("[UDP SERVER ~ ERROR] : SO_REUSEPORT");
+        exit(0);
+    }
+
     memset(&bindUdpPort, 0 , sizeof(struct sockaddr_in));
 
     bindUdpPort.sin_family = AF_INET;
@@ -239,12 +367,37 @@ ServerStreamParams* Server::CreateUdpServer(uint16_t portNo)
         exit(0);
     }
 
+    //What the socket drops is not lost by the network
+    if(!SocketOptions::SetRxQueueOverflow(socketId))
+        perror("[UDP SERVER ~ INFO] : SO_RXQ_OVFL");
+
+    params->rcvbuf = SocketOptions::GrowBuffer(socketId , true , std::min<uint32_t>(SOCKET_BUFFER_INITIAL , socketBufferCap));
+
     params->socketId      = socketId;
     params->port          = portNo;
+    params->shard         = 0;
     params->udpPacketSize = udpPacketSize;
     params->udpSeqNumber  = 0;
     params->measureOneWay = measureOneWay;
-    params->measurements  = new Measurements();
+    params->measurements  = NULL;
+    params->latency       = NULL;
+    params->lastPhase     = 0;
+    params->prevLatency   = 0.0;
+    params->woken         = true;
+    params->inode         = SocketOptions::GetInode(socketId);
+    params->rxqDrops      = 0;
+    params->diagDrops     = 0;
+    params->peakQueued    = 0;
+    params->lastSeqNumber = 0;
+    params->minTransit    = INT64_MAX;
+    params->dirty         = false;
+    params->wakeLatency[0] = NULL;
+    params->wakeLatency[1] = NULL;
+    params->totalSyscalls = 0;
+    params->groBuffers    = 0;
+    params->groDatagrams  = 0;
+    memset(params->rxTimestampSources , 0 , sizeof(params->rxTimestampSources));
+    memset(params->recvBatches , 0 , sizeof(params->recvBatches));
 
     openSockets.push_back(socketId);
     bindUdpAddresses.push_back(bindUdpPort);
@@ -253,400 +406,1603 @@ ServerStreamParams* Server::CreateUdpServer(uint16_t portNo)
     return params;
 }
 
+void Server::CreateReceivers()
+{
+    //A fixed pool of threads , every one of them waits on the sockets of its share of the streams
+    uint32_t numberOfReceivers = numberOfReceiverThreads;
+
+    if(!numberOfReceivers)
+        numberOfReceivers = std::max<uint32_t>(std::thread::hardware_concurrency() , 1);
+
+    numberOfReceivers = std::min<uint32_t>(numberOfReceivers , std::max<size_t>(openPorts.size() * numberOfShards , 1));
+
+    for(uint32_t index = 0; index < numberOfReceivers; index++)
+    {
+        ServerReceiver* receiver = new ServerReceiver;
+
+        receiver->thread       = NULL;
+        receiver->ringSyscalls = 0;
+        receiver->loopSyscalls = 0;
+        receiver->loopSleeps   = 0;
+
+        //Set up here , a stop may come before the thread runs
+        if(!receiver->loop.Setup())
+        {
+            perror("[UDP SERVER ~ ERROR] : unable to create an event loop");
+            exit(0);
+        }
+
+        receiver->loop.SetBusyPoll(busyPollNano);
+
+        receivers.push_back(receiver);
+    }
+}
+
 void Server::CreateStream(uint16_t portNo)
 {
-    ServerStreamParams* params = CreateUdpServer(portNo);
+    std::shared_ptr<std::atomic<uint64_t>> streamSeqNumber;
 
-    auto receiverHandler = [this](ServerStreamParams* params)
+    //The shards count what the client sent (in an interval or a phase) together
+    if(numberOfShards > 1)
+        streamSeqNumber = std::make_shared<std::atomic<uint64_t>>(0);
+
+    for(uint16_t shard = 0; shard < numberOfShards; shard++)
     {
-        fd_set readDescriptors;
-        int maxFd = params->socketId;
+        ServerStreamParams* params = CreateUdpServer(portNo);
 
-        struct sockaddr_in udpClientAddr;
+        params->shard           = shard;
+        params->streamSeqNumber = streamSeqNumber;
 
-        memset(&udpClientAddr , 0 , sizeof(struct sockaddr_in));
+        //Edge triggered , the receiver reads until the socket is empty
+        if(fcntl(params->socketId , F_SETFL , fcntl(params->socketId , F_GETFL) | O_NONBLOCK))
+            perror("[UDP SERVER ~ INFO] : unable to make the socket non blocking");
 
-        uint32_t sockAddrinLen = sockAddrinLen = sizeof(struct sockaddr_in);
+        //The multishot recv of io_uring has no control messages , it could not tell where the datagrams end
+        if(useGro && !useIoUring && !SocketOptions::SetUdpGro(params->socketId))
+            perror("[UDP SERVER ~ INFO] : UDP_GRO , the datagrams come one by one");
 
-        //This is for jitter
-        Time arriveTime;
-        Time sendTime;
-        Time diff;
-        double latency;
-        double prevLatency;
+        //Nor the timestamps
+        if(rxTimestamps != RX_TIMESTAMP_USER && !useIoUring &&
+           !SocketOptions::SetRxTimestamping(params->socketId , rxTimestamps == RX_TIMESTAMP_HARDWARE))
+            perror("[UDP SERVER ~ INFO] : SO_TIMESTAMPING , the arrival times come from user space");
 
-        std::size_t padding;    
-        uint64_t    nowPacket;
+        if(busyPollNano && !SocketOptions::SetBusyPoll(params->socketId , std::max<uint64_t>(busyPollNano / 1000 , 1)))
+            perror("[UDP SERVER ~ INFO] : SO_BUSY_POLL , only the receiver spins");
 
-        int64_t  recvLen;
-        uint8_t  udpBuffer[params->udpPacketSize];
+        //Round robin , the streams share the same rate so every receiver gets the same load. With as many
+        //receivers as shards , a receiver gets the same shard of every stream.
+        receivers[(totalParams.size() - 1) % receivers.size()]->streams.push_back(params);
+    }
 
-        auto UDPRecv = [&](int socketId)
-        {
-            recvLen = recvfrom(socketId, udpBuffer, params->udpPacketSize, 0 , (struct sockaddr*)&udpClientAddr, &sockAddrinLen);
-            
-            //Something went wrong with the recvfrom
-            if(recvLen <= 0)
-                fprintf(stderr, "[UDP SERVER ~ ERROR] : failed while trying to receive some data!\n");
-            else
-            {
-                SystemClock::GetSystemTime(&arriveTime);
-                
-                if(!params->udpSeqNumber)
-                    params->startTime = arriveTime;
+    //The group exists once every shard is bound
+    if(numberOfShards > 1 && shardByCpu && !SocketOptions::SetCpuSteering(totalParams.back()->socketId , numberOfShards))
+        perror("[UDP SERVER ~ INFO] : unable to steer the shards by cpu , they share the datagrams by flow");
+}
 
-                diff = SystemClock::GetElapsedTime(&params->startTime , &arriveTime);
-                params->measurements->timeUntilNow = SystemClock::GetTimeInSeconds(&diff);                
+void Server::StartReceivers()
+{
+    Time     now;
+    uint32_t retained = std::max<uint64_t>(((uint64_t)retention * ONE_SECOND_TO_NANO) / intervalNano , 1);
 
-                memcpy(&nowPacket, udpBuffer, sizeof(uint64_t));
-                nowPacket = reverseBytes(nowPacket);
-                
-                SystemClock::Derialize(&sendTime , udpBuffer, sizeof(uint64_t));
+    //Every stream counts its intervals from the same epoch , the reports start over with them
+    SystemClock::GetSystemTime(&now);
+    intervalEpoch = SystemClock::GetTimeInNanoSeconds(&now);
 
-                diff    = SystemClock::GetElapsedTime(&sendTime , &arriveTime);
-                latency = SystemClock::GetTimeInSeconds(&diff);
-                
-                params->measurements->totalPackets++;
+    serverReportInterval   = 0;
+    clientReportInterval   = 0;
+    clientReportLocalDrops = 0;
+    ewmaInterval           = 0;
+    ewmaThroughtput        = 0.0;
 
-                if(!params->measureOneWay)
-                {
-                    //Throughput and goodput
-                    params->measurements->totalBytesReceived    += recvLen;
-                    params->measurements->totalBytesReceivedWll += (recvLen + HEADERS_FROM_THE_LAYERS);
-
-                    params->measurements->averageThroughtput = (((params->measurements->totalBytesReceivedWll * 8) / params->measurements->timeUntilNow) / 1000000.0);
-                    params->measurements->averageGoodput     = (((params->measurements->totalBytesReceived * 8) / params->measurements->timeUntilNow) / 1000000.0);
-                    
-                    //Find jitter
-                    //We calculate the jitter using the RTP protocol formula
-                    double jitter;
-                    double dt;
-                    if( (dt = latency - prevLatency) < 0 )
-                        dt = -dt; 
-                    
-                    prevLatency = latency;
-                    jitter      = (dt - params->measurements->jitter);
-
-                    params->measurements->jitter += jitter / 16.0;
-
-                    params->measurements->PushJitter(jitter);
-
-                    //Find packets lost
-                    if(nowPacket >= (params->udpSeqNumber + 1))
-                    {
-                        //We have lost some packets.
-                        if(nowPacket > (params->udpSeqNumber + 1))
-                            params->measurements->packetLost += (nowPacket - params->udpSeqNumber - 1);
-                        
-                        params->udpSeqNumber = nowPacket;
-                        params->measurements->totalPacketsThatTheClientHaveSend = nowPacket;
-                    }else
-                    {
-                        //We see a packet that came out of order.
-                        if(params->measurements->packetLost > 0)
-                            params->measurements->packetLost--;
-                    }
-                }
-                else
-                {   
-                    //We assume that the one way delay is RTT/2 which is equal with the time 
-                    //that the packet spend to came here (client --> server).
-                    params->measurements->oneWayDelay = latency;
-                }
-            }
-        };
+    auto receiverHandler = [this , retained](ServerReceiver* receiver , uint32_t index , std::promise<void>* ready)
+    {
+        //Pinned first , the measurements are then allocated (and first touched) on the node of the thread
+        affinity.PinStream(index);
 
-        SystemClock::GetSystemTime(&params->startTime);
-        while(!this->isClientStop && !this->stopRunning)
+        for(auto params : receiver->streams)
         {
-            struct timeval timeout;
-            timeout.tv_sec  = 1;
-            timeout.tv_usec = 0; 
+            params->measurements = new Measurements();
+            params->latency      = new LatencyHistogram();
+            params->wakeLatency[0] = new LatencyHistogram();
+            params->wakeLatency[1] = new LatencyHistogram();
+            params->phaseMeasurements.assign(phases.size() , Measurements());
+            params->dirtyPhases.assign(phases.size() , 0);
+            params->phaseSnapshots.reset(new SeqLock<Measurements>[phases.size()]);
+            params->intervals.Setup(intervalEpoch , intervalNano , retained + 1);
+
+            PublishStream(receiver , params);
+        }
 
-            FD_ZERO(&readDescriptors);
+        ready->set_value();
 
-            FD_SET(params->socketId , &readDescriptors);
-            int select_val = select(maxFd + 1, &readDescriptors , NULL , NULL, &timeout);
-            if(select_val < 0)
-            {
-                perror("[UDP SERVER (STREAM) ~ INFO] : ");
+        for(auto params : receiver->streams)
+            SystemClock::GetSystemTime(&params->startTime);
+
+        if(useIoUring)
+        {
+            if(RunReceiverIoUring(receiver))
                 return;
-            }else if(select_val == 0)
-                continue;
 
-            if(FD_ISSET(params->socketId, &readDescriptors))
-                UDPRecv(params->socketId);
+            perror("[UDP SERVER ~ INFO] : io_uring , falling back to epoll");
         }
 
-        return;
+        RunReceiver(receiver);
     };
 
-    std::thread* newStream = new std::thread(receiverHandler , params);
-    openStreams.push_back(newStream);
+    for(uint32_t index = 0; index < receivers.size(); index++)
+    {
+        std::promise<void> ready;
+
+        receivers[index]->thread = new std::thread(receiverHandler , receivers[index] , index , &ready);
+
+        //The TCP thread reads the measurements of every stream
+        ready.get_future().wait();
+    }
+}
+
+void Server::StopReceivers()
+{
+    for(auto receiver : receivers)
+        receiver->loop.Stop();
 }
 
 // ======================================================================================================================================= 
-// ==================================================== TCP functions ==================================================================== 
-// =======================================================================================================================================
+// ==================================================== Receivers ======================================================================== 
+// ======================================================================================================================================= 
 
-void Server::TCPSend(NerfPacket& packet)
+void Server::PushPacket(ServerStreamParams* params , uint8_t* packet , int64_t recvLen , Time* arriveTime)
 {
-    uint8_t buffer[NERF_PACKET_SIZE];
-    size_t sendBytes;
-
-    packet.Serialize(buffer);
+    Time     sendTime;
+    Time     diff;
+    double   latency;
+    uint64_t nowPacket;
 
-    sendBytes = send(connectedClient , buffer , NERF_PACKET_IN_BYTES , 0);
-}
+    if(!params->udpSeqNumber)
+        params->startTime = *arriveTime;
 
-void Server::TCPRecv()
-{
-    int64_t recvLen;
+    diff = SystemClock::GetElapsedTime(&params->startTime , arriveTime);
+    params->measurements->timeUntilNow = SystemClock::GetTimeInSeconds(&diff);                
 
-    recvLen = recv(connectedClient, tcpbuffer, NERF_PACKET_IN_BYTES, 0);
+    memcpy(&nowPacket, packet, sizeof(uint64_t));
+    nowPacket = reverseBytes(nowPacket);
+    
+    SystemClock::Derialize(&sendTime , packet, sizeof(uint64_t));
 
-    NerfPacket packet = NerfPacket::Deserialize(tcpbuffer);
-    ParsePacket(packet);
-}
+    uint64_t arrivalNano = SystemClock::GetTimeInNanoSeconds(arriveTime);
+    int64_t  transitNano = (int64_t)arrivalNano - (int64_t)SystemClock::GetTimeInNanoSeconds(&sendTime);
 
-void Server::ParsePacket(NerfPacket& packet)
-{
-    switch(packet.flags)
+    if(params->measureOneWay)
     {
-        case START:
-        {
-            startPrintData = true;
+        //The skew is fitted to the transit times on the two clocks , a new lowest one is rare
+        int64_t lowest = params->minTransit.load(std::memory_order_relaxed);
+        while(transitNano < lowest && !params->minTransit.compare_exchange_weak(lowest , transitNano , std::memory_order_relaxed));
 
-            SystemClock::GetSystemTime(&startTestTime);
-        }break;
+        //The send time on the clock of the server
+        transitNano += clockSync.GetOffset(arrivalNano);
+    }
 
-        case SETUP:
-        {
-            memcpy(&udpPacketSize, packet.payload, sizeof(uint32_t));
-            memcpy(&numberOfParallelStreams, packet.payload + sizeof(uint32_t), sizeof(uint16_t));
-            memcpy(&measureOneWay, packet.payload + sizeof(uint32_t) + sizeof(uint16_t), sizeof(uint8_t));
-            memcpy(&clientPrintResultsInterval, 
-                    packet.payload + sizeof(uint32_t) + sizeof(uint16_t) + sizeof(uint8_t), 
-                    sizeof(double));
-            memcpy(&printResultAccordingTimeClient, 
-                    packet.payload + sizeof(uint32_t) + sizeof(uint16_t) + sizeof(uint8_t) + sizeof(double), 
-                    sizeof(uint8_t));
+    latency = transitNano / (double)ONE_SECOND_TO_NANO;
 
-            clientTotalPrintResultsInterval = clientPrintResultsInterval;
+    //A clock that is behind the one of the client makes it negative
+    uint64_t latencyNano = (latency > 0.0) ? (uint64_t)(latency * ONE_SECOND_TO_NANO) : 0;
+    uint64_t advanced    = 0;
+    double   dt          = 0.0;
+    
+    params->measurements->totalPackets++;
+    params->dirty = true;
 
-            if(!numberOfParallelStreams)
-                numberOfParallelStreams++;
-            
-            for(uint16_t ports = 0; ports < numberOfParallelStreams; ports++)
-                openPorts.push_back(++port);
+    if(!params->measureOneWay)
+    {
+        //Throughput and goodput
+        params->measurements->totalBytesReceived    += recvLen;
+        params->measurements->totalBytesReceivedWll += (recvLen + HEADERS_FROM_THE_LAYERS);
+
+        params->measurements->averageThroughtput = (((params->measurements->totalBytesReceivedWll * 8) / params->measurements->timeUntilNow) / 1000000.0);
+        params->measurements->averageGoodput     = (((params->measurements->totalBytesReceived * 8) / params->measurements->timeUntilNow) / 1000000.0);
+        
+        //Find jitter
+        if( (dt = latency - params->prevLatency) < 0 )
+            dt = -dt; 
+        
+        params->prevLatency = latency;
+
+        params->measurements->PushJitter(dt);
+
+        //Find packets lost , reordered (RFC 4737) and duplicated
+        uint32_t extent;
+        uint8_t  order = params->reorderWindow.Push(nowPacket , &extent);
+
+        //What the client sent is how far the highest sequence number moved
+        uint64_t highest = params->udpSeqNumber;
+
+        //Of the whole stream , whichever shard moves it counts the packets in between
+        if(params->streamSeqNumber)
+        {
+            highest = params->streamSeqNumber->load(std::memory_order_relaxed);
+            while(nowPacket > highest && !params->streamSeqNumber->compare_exchange_weak(highest , nowPacket , std::memory_order_relaxed));
+        }
 
-            NerfPacket ports = NerfPacket::MakePortNumberPacket(openPorts);
+        advanced = (nowPacket > highest) ? nowPacket - highest : 0;
 
-            TCPSend(ports);
-        }break;
-    
-        case LAST_PACKET:
-        {
-            uint64_t lastUdpSeqNumber;
-            uint64_t currenrUdpSeqNumber;
-            uint16_t port;
-            
-            memcpy(&port, packet.payload, sizeof(uint16_t));
-            memcpy(&lastUdpSeqNumber, packet.payload + sizeof(uint16_t), sizeof(uint64_t));
-            
-            for(auto stream : totalParams)
-            {
-                if(stream->port == port)
-                {
-                    currenrUdpSeqNumber = stream->udpSeqNumber;
-                    if(currenrUdpSeqNumber > lastUdpSeqNumber)
-                        stream->measurements->packetLost -= (currenrUdpSeqNumber - lastUdpSeqNumber);
-                    
-                    stream->measurements->totalPacketsThatTheClientHaveSend = lastUdpSeqNumber;
-                    break;
-                }
-            }
-        }break;
+        if(!params->phaseMeasurements.empty())
+            PushPhasePacket(params , &sendTime , recvLen , advanced , dt , order == REORDER_DUPLICATE);
 
-        case CLOSE:
+        switch(order)
         {
-            //Remove Client
-            if(!isClientStop)
-                isClientStop = true;
+            case REORDER_NEXT:
+            {
+                //We have lost some packets (unless they come later).
+                if(nowPacket > (params->udpSeqNumber + 1))
+                    params->measurements->packetLost += (nowPacket - params->udpSeqNumber - 1);
 
-            SendMeasurements();
-        }break;
+                params->udpSeqNumber = nowPacket;
+                params->measurements->totalPacketsThatTheClientHaveSend = nowPacket;
+            }break;
 
-        default:
-        {
-        }break;
-    }
-}
+            case REORDER_LATE:
+            {
+                //It filled a hole , counted as lost when it was passed over
+                params->measurements->reordered++;
+                params->measurements->reorderExtent   += extent;
+                params->measurements->maxReorderExtent = std::max<uint64_t>(params->measurements->maxReorderExtent , extent);
 
-void Server::GetMeasurementsForEachStream()
-{
-    assert(totalParams.size() > 0);
+                if(params->measurements->packetLost > 0)
+                    params->measurements->packetLost--;
+            }break;
 
-    uint32_t streamsSize = totalParams.size();
+            case REORDER_TOO_OLD:
+            {
+                //Far too late to tell , taken for a reordered packet of an unknown extent
+                params->measurements->reordered++;
 
-    //copy the measurements
-    memcpy(measurements , totalParams[0]->measurements , sizeof(Measurements));
+                if(params->measurements->packetLost > 0)
+                    params->measurements->packetLost--;
+            }break;
 
-    for(int stream = 1; stream < streamsSize; stream++)
-    {
-        if(!measureOneWay)
-        {
-            Measurements::CombineThroughtputs(measurements , totalParams[stream]->measurements);
-            Measurements::CombineGoodputs(measurements , totalParams[stream]->measurements);
-            Measurements::CombinePacketLost(measurements , totalParams[stream]->measurements);
-            Measurements::CombineJitters(measurements , totalParams[stream]->measurements);
-            Measurements::CombineJittersDeviations(measurements , totalParams[stream]->measurements);
+            case REORDER_DUPLICATE:
+            {
+                params->measurements->duplicates++;
+            }break;
         }
-        else
-            Measurements::CombineOneWayDelay(measurements , totalParams[stream]->measurements);     
     }
+    else
+    {   
+        //We assume that the one way delay is RTT/2 which is equal with the time 
+        //that the packet spend to came here (client --> server). Every packet counts , the
+        //reports are percentiles.
+        params->latency->Record(latencyNano);
+        params->wakeLatency[params->woken]->Record(latencyNano);
+    }
+
+    //The interval it arrived in , for the reports over time
+    params->intervals.Push(SystemClock::GetTimeInNanoSeconds(arriveTime) , recvLen , recvLen + HEADERS_FROM_THE_LAYERS , advanced , dt , latencyNano);
 }
 
-void Server::SendMeasurements()
+void Server::PublishStream(ServerReceiver* receiver , ServerStreamParams* params)
 {
-    NerfPacket measurementsToSend;
+    ServerStreamSnapshot snapshot;
 
-    //Cobine the measurements for each stream
-    GetMeasurementsForEachStream();
+    snapshot.measurements  = *params->measurements;
+    snapshot.lastPhase     = params->lastPhase;
+    snapshot.totalSyscalls = params->totalSyscalls;
+    snapshot.groBuffers    = params->groBuffers;
+    snapshot.groDatagrams  = params->groDatagrams;
+    snapshot.rxqDrops      = params->rxqDrops;
+    memcpy(snapshot.recvBatches , params->recvBatches , sizeof(snapshot.recvBatches));
+    memcpy(snapshot.rxTimestampSources , params->rxTimestampSources , sizeof(snapshot.rxTimestampSources));
 
-    if(!measureOneWay)
-    {
-        measurementsToSend = NerfPacket::MakeMeasurementsPacket(0,
-                                                                measurements->GetThroughtput(),
-                                                                measurements->GetGoodput(),
-                                                                measurements->GetPacketLostPercentage(), 
-                                                                measurements->GetJitter(), 
-                                                                measurements->GetJitterStandardDeviation());
-    }
-    else                                                                     
+    params->snapshot.Write(snapshot);
+    params->dirty = false;
+
+    for(uint32_t phase = 0; phase < params->dirtyPhases.size(); phase++)
     {
-        measurementsToSend = NerfPacket::MakeMeasurementsPacket(1 , measurements->GetOneWayDelay());
+        if(!params->dirtyPhases[phase])
+            continue;
+
+        params->phaseSnapshots[phase].Write(params->phaseMeasurements[phase]);
+        params->dirtyPhases[phase] = 0;
     }
 
-    TCPSend(measurementsToSend);
+    receiver->loopSyscalls.store(receiver->loop.totalSyscalls , std::memory_order_relaxed);
+    receiver->loopSleeps.store(receiver->loop.totalSleeps , std::memory_order_relaxed);
 }
 
-// ======================================================================================================================================= 
-// ======================================================= Run =========================================================================== 
-// ======================================================================================================================================= 
-
-void Server::RunServer()
+void Server::RunReceiver(ServerReceiver* receiver)
 {
-    int64_t recvLen;
-    uint32_t nowPacket;
-
-    for(auto port : openPorts)
-        CreateStream(port);
+    uint32_t udpPacketSize = receiver->streams[0]->udpPacketSize;
+    Time     arriveTime;
 
-    auto tcpHandler = [this]()
-    {   
-        double duration = 0.0f;
+    //A coalesced buffer holds as many datagrams as an IP packet does
+    uint32_t bufferSize = useGro ? GRO_MAX_BYTES : udpPacketSize;
 
-        while(!this->isClientStop && !this->stopRunning)
-        {
-            struct timeval timeout;
-            timeout.tv_sec  = 1;
-            timeout.tv_usec = 0; 
-            
-            if(startPrintData)
-            {
-                SystemClock::GetSystemTime(&nowTime);
+    std::vector<uint8_t> udpBuffer(bufferSize);
+    uint8_t              udpControl[RECV_CONTROL_LEN];
+    struct iovec         udpIovec;
+    struct msghdr        udpMessage;
 
-                diff = SystemClock::GetElapsedTime(&startTestTime , &nowTime);
-                duration = SystemClock::GetTimeInSeconds(&diff);
-                
-                // 0 == print results in the end
-                if(printResultAccordingTimeClient && duration >= clientTotalPrintResultsInterval)
-                {
-                    clientTotalPrintResultsInterval += clientPrintResultsInterval;
-                    SendMeasurements();
-                }
+    udpIovec.iov_base = udpBuffer.data();
+    udpIovec.iov_len  = bufferSize;
 
-                if(printResultAccordingTime && duration >= totalPrintResultsInterval)
-                {
-                    totalPrintResultsInterval += printResultsInterval;
-                    PrintResults();
-                }
-            }
+    memset(&udpMessage , 0 , sizeof(struct msghdr));
+    udpMessage.msg_iov    = &udpIovec;
+    udpMessage.msg_iovlen = 1;
 
-            FD_ZERO(&readDescriptors);
+    //Whatever is queued , up to a batch per recvmmsg. The datagrams were all waiting in the socket
+    //when the call returned , they share its arrival time.
+    std::vector<uint8_t>        batchBuffers;
+    std::vector<struct mmsghdr> batchMessages;
+    std::vector<struct iovec>   batchIovecs;
+    std::vector<uint8_t>        batchControls;
 
-            FD_SET(connectedClient , &readDescriptors);
-            maxFd = connectedClient;
+    if(recvBatchSize > 1)
+    {
+        batchBuffers.resize((uint64_t)recvBatchSize * bufferSize);
+        batchMessages.resize(recvBatchSize);
+        batchIovecs.resize(recvBatchSize);
+        batchControls.resize((uint64_t)recvBatchSize * RECV_CONTROL_LEN);
 
-            int select_val = select(maxFd + 1, &readDescriptors , NULL , NULL, &timeout);
-            if(select_val < 0)
-            {
-                perror("[TCP SERVER ~ INFO] : ");
-                return;
-            }else if(select_val == 0)
-                continue;
+        for(uint32_t message = 0; message < recvBatchSize; message++)
+        {
+            batchIovecs[message].iov_base = &batchBuffers[(uint64_t)message * bufferSize];
+            batchIovecs[message].iov_len  = bufferSize;
 
-            if(FD_ISSET(connectedClient , &readDescriptors))
-                TCPRecv();
+            memset(&batchMessages[message] , 0 , sizeof(struct mmsghdr));
+            batchMessages[message].msg_hdr.msg_iov    = &batchIovecs[message];
+            batchMessages[message].msg_hdr.msg_iovlen = 1;
         }
+    }
+
+    //The kernel overwrites the length of the control buffer , it is given again before every call
+    auto SetControl = [&](struct msghdr* header , uint8_t* control)
+    {
+        header->msg_control    = control;
+        header->msg_controllen = RECV_CONTROL_LEN;
     };
 
-    std::thread tcpThread(tcpHandler);
-    tcpThread.join();
+    //The kernel stamps in CLOCK_REALTIME (the NIC in its own clock , kept in step with it by phc2sys) , the
+    //measurements in CLOCK_MONOTONIC. The offset is read again on every wakeup , it follows the NTP steps.
+    int64_t realtimeOffset = 0;
 
-    for(auto openStream : openStreams)
-        openStream->join();
+    //Every datagram of a coalesced buffer is measured on its own , they all arrived with the buffer
+    auto PushBuffer = [&](ServerStreamParams* params , uint8_t* buffer , int64_t recvLen , struct msghdr* header)
+    {
+        int64_t segmentSize = useGro ? SocketOptions::GetGroSegmentSize(header) : 0;
+        Time*   arrival     = &arriveTime;
+        Time    stamp;
 
-    //Print the final results for the server side
-    PrintResults();
-}
+        if(!segmentSize || segmentSize >= recvLen)
+            segmentSize = recvLen;
 
-void Server::Run()
-{
-    struct sockaddr_in clientAddr;
-    
-    uint32_t addrLen = sizeof(struct sockaddr_in);
-    int64_t recvLen;
+        SocketOptions::GetRxQueueOverflow(header , &params->rxqDrops);
 
-    while ( !stopRunning )
-    {
-        connectedClient = accept(socketTcpId , (struct sockaddr*)&clientAddr , &addrLen);
-        if(connectedClient >= 0)
+        //The time the datagram came in , before the wakeup and the system call (a coalesced buffer has the one of its first datagram)
+        if(rxTimestamps != RX_TIMESTAMP_USER)
         {
-            fprintf(stdout, "\n[TCP SERVER ~ LOG] : connection from ( %s , %d ).\n", inet_ntoa(clientAddr.sin_addr),ntohs(clientAddr.sin_port));
+            uint8_t source = SocketOptions::GetRxTimestamp(header , &stamp);
 
-            Reset();
+            if(source != RX_TIMESTAMP_USER)
+            {
+                stamp   = SystemClock::GetTimeFromNanoSeconds(SystemClock::GetTimeInNanoSeconds(&stamp) - realtimeOffset);
+                arrival = &stamp;
 
-            //wait until will receive the SETUP packet from the client
-            TCPRecv();
+                params->rxTimestampSources[source] += (recvLen + segmentSize - 1) / segmentSize;
+            }
+        }
 
-            RunServer();
+        if(segmentSize == recvLen)
+        {
+            PushPacket(params , buffer , recvLen , arrival);
+            return;
         }
 
-        //close the connection 
-        close(connectedClient);
-    }
-}
+        params->groBuffers++;
 
-// ======================================================================================================================================= 
-// ==================================================== Print FUnctions ==================================================================
-// =======================================================================================================================================
+        //The last datagram may be shorter than the segment size
+        for(int64_t offset = 0; offset < recvLen; offset += segmentSize)
+        {
+            params->groDatagrams++;
+            PushPacket(params , buffer + offset , std::min(segmentSize , recvLen - offset) , arrival);
+        }
+    };
+
+    //Both read until the socket is empty (true) , or until the stream used its budget (false)
+    auto UDPRecv = [&](ServerStreamParams* params) -> bool
+    {
+        if(rxTimestamps != RX_TIMESTAMP_USER)
+            realtimeOffset = SystemClock::GetRealtimeOffset();
+
+        params->woken = receiver->loop.Woken();
+
+        for(uint32_t received = 0; received < RECEIVER_DRAIN_BUDGET; received++)
+        {
+            params->totalSyscalls++;
+
+            SetControl(&udpMessage , udpControl);
+
+            int64_t recvLen = recvmsg(params->socketId, &udpMessage, MSG_DONTWAIT);
+            if(recvLen < 0)
+            {
+                if(errno != EAGAIN && errno != EWOULDBLOCK)
+                    perror("[UDP SERVER ~ ERROR] : failed while trying to receive some data");
+                return true;
+            }
+
+            SystemClock::GetSystemTime(&arriveTime);
+
+            if(recvLen > 0)
+                PushBuffer(params , udpBuffer.data() , recvLen , &udpMessage);
+        }
+
+        return false;
+    };
+
+    auto UDPRecvBatch = [&](ServerStreamParams* params) -> bool
+    {
+        if(rxTimestamps != RX_TIMESTAMP_USER)
+            realtimeOffset = SystemClock::GetRealtimeOffset();
+
+        params->woken = receiver->loop.Woken();
+
+        for(uint32_t received = 0; received < RECEIVER_DRAIN_BUDGET; received += recvBatchSize)
+        {
+            params->totalSyscalls++;
+
+            for(uint32_t message = 0; message < recvBatchSize; message++)
+                SetControl(&batchMessages[message].msg_hdr , &batchControls[(uint64_t)message * RECV_CONTROL_LEN]);
+
+            int messages = recvmmsg(params->socketId, batchMessages.data(), recvBatchSize, MSG_DONTWAIT, NULL);
+            if(messages <= 0)
+            {
+                if(messages < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+                    perror("[UDP SERVER ~ ERROR] : failed while trying to receive some data");
+                return true;
+            }
+
+            SystemClock::GetSystemTime(&arriveTime);
+
+            params->recvBatches[std::min<int>(31 - __builtin_clz(messages) , RECV_BATCH_BUCKETS - 1)]++;
+
+            for(int message = 0; message < messages; message++)
+                if(batchMessages[message].msg_len > 0)
+                    PushBuffer(params , (uint8_t*)batchIovecs[message].iov_base , batchMessages[message].msg_len , &batchMessages[message].msg_hdr);
+
+            //A short batch emptied the socket , whatever comes next is a new edge
+            if((uint32_t)messages < recvBatchSize)
+                return true;
+        }
+
+        return false;
+    };
+
+    //A snapshot per drain , whether it emptied the socket or used its budget
+    for(auto params : receiver->streams)
+    {
+        bool added = receiver->loop.Add(params->socketId , true , [this , receiver , params , &UDPRecv , &UDPRecvBatch]()
+        {
+            bool drained = (recvBatchSize > 1) ? UDPRecvBatch(params) : UDPRecv(params);
+
+            PublishStream(receiver , params);
+
+            return drained;
+        });
+
+        if(!added)
+            perror("[UDP SERVER (STREAM) ~ INFO] : epoll_ctl");
+    }
+
+    receiver->loop.Run();
+}
+
+bool Server::RunReceiverIoUring(ServerReceiver* receiver)
+{
+    IoUring  ring;
+    Time     arriveTime;
+    uint32_t numberOfBuffers = std::min<uint64_t>((uint64_t)IO_URING_RECV_BUFFERS * receiver->streams.size() , IO_URING_MAX_BUFFERS);
+
+    if(!ring.Setup(IO_URING_RECV_BUFFERS) || !ring.SetupBuffers(numberOfBuffers , receiver->streams[0]->udpPacketSize))
+        return false;
+
+    //A multishot recv per stream , it ends when the kernel runs out of buffers and is armed again
+    auto Arm = [&](uint32_t stream)
+    {
+        struct io_uring_sqe* sqe = ring.GetSqe();
+
+        if(!sqe)
+        {
+            ring.Submit(0);
+            sqe = ring.GetSqe();
+        }
+
+        IoUring::PrepareRecvMultishot(sqe , receiver->streams[stream]->socketId , stream);
+    };
+
+    for(uint32_t stream = 0; stream < receiver->streams.size(); stream++)
+        Arm(stream);
+
+    if(ring.Submit(0) < 0)
+        return false;
+
+    //The ring is readable once it has completions , the loop wakes for them (or for the stop) alone
+    auto Reap = [&]() -> bool
+    {
+        bool rearmed = false;
+
+        SystemClock::GetSystemTime(&arriveTime);
+
+        for(struct io_uring_cqe* cqe = ring.PeekCqe(); cqe; cqe = ring.PeekCqe())
+        {
+            if(cqe->user_data == IO_URING_PROVIDE_BUFFERS)
+            {
+                errno = -cqe->res;
+                perror("[UDP SERVER (STREAM) ~ INFO] : unable to recycle the io_uring buffers");
+                ring.SeenCqe();
+                continue;
+            }
+
+            ServerStreamParams* params = receiver->streams[cqe->user_data];
+
+            params->woken = receiver->loop.Woken();
+
+            if(cqe->flags & IORING_CQE_F_BUFFER)
+            {
+                uint16_t bufferId = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+
+                if(cqe->res > 0)
+                    PushPacket(params , ring.GetBuffer(bufferId) , cqe->res , &arriveTime);
+
+                ring.RecycleBuffer(bufferId);
+            }
+            else if(cqe->res < 0 && cqe->res != -ENOBUFS)
+            {
+                errno = -cqe->res;
+                perror("[UDP SERVER ~ ERROR] : failed while trying to receive some data");
+            }
+
+            if(!(cqe->flags & IORING_CQE_F_MORE))
+            {
+                Arm(cqe->user_data);
+                rearmed = true;
+            }
+
+            ring.SeenCqe();
+        }
+
+        //The new recvs right away , the recycled buffers once there are enough of them to be worth a system call
+        if(rearmed || ring.GetRecycledBuffers() >= IO_URING_RECYCLE_BATCH)
+            ring.Submit(0);
+
+        receiver->ringSyscalls.store(ring.totalSyscalls , std::memory_order_relaxed);
+
+        //The streams of the batch , once
+        for(auto params : receiver->streams)
+            if(params->dirty)
+                PublishStream(receiver , params);
+
+        return true;
+    };
+
+    if(!receiver->loop.Add(ring.GetRingId() , true , Reap))
+        return false;
+
+    receiver->loop.Run();
+
+    return true;
+}
+
+// ======================================================================================================================================= 
+// ==================================================== TCP functions ==================================================================== 
+// =======================================================================================================================================
+
+void Server::TCPSend(NerfPacket& packet)
+{
+    uint8_t buffer[NERF_PACKET_SIZE];
+    size_t sendBytes;
+
+    packet.Serialize(buffer);
+
+    sendBytes = send(connectedClient , buffer , NERF_PACKET_IN_BYTES , 0);
+}
+
+uint8_t Server::TCPRecv()
+{
+    int64_t recvLen;
+
+    //The client may send several packets back to back (the profile phases)
+    recvLen = recv(connectedClient, tcpbuffer, NERF_PACKET_IN_BYTES, MSG_WAITALL);
+
+    //The client closed the connection
+    if(recvLen < (int64_t)NERF_PACKET_IN_BYTES)
+        return ERROR;
+
+    NerfPacket packet = NerfPacket::Deserialize(tcpbuffer);
+    ParsePacket(packet);
+
+    return packet.flags;
+}
+
+void Server::ParsePacket(NerfPacket& packet)
+{
+    switch(packet.flags)
+    {
+        case START:
+        {
+            uint64_t startTime;
+
+            startPrintData = true;
+
+            SystemClock::GetSystemTime(&startTestTime);
+
+            memcpy(&startTime, packet.payload, sizeof(uint64_t));
+            phasesStartTime = startTime;
+        }break;
+
+        case PHASE:
+        {
+            ServerPhase phase;
+            uint16_t    index;
+
+            memcpy(&index,          packet.payload,                                        sizeof(uint16_t));
+            memcpy(&phase.start,    packet.payload + sizeof(uint16_t),                     sizeof(uint64_t));
+            memcpy(&phase.duration, packet.payload + sizeof(uint16_t) + sizeof(uint64_t),  sizeof(uint64_t));
+            phase.description = (const char*)(packet.payload + sizeof(uint16_t) + (2 * sizeof(uint64_t)));
+
+            //The phases come before the SETUP , once more at the end with how long they actually lasted
+            if(index == phases.size())
+                phases.push_back(phase);
+            else if(index < phases.size())
+                phases[index].duration = phase.duration;
+        }break;
+
+        case SETUP:
+        {
+            memcpy(&udpPacketSize, packet.payload, sizeof(uint32_t));
+            memcpy(&numberOfParallelStreams, packet.payload + sizeof(uint32_t), sizeof(uint16_t));
+            memcpy(&measureOneWay, packet.payload + sizeof(uint32_t) + sizeof(uint16_t), sizeof(uint8_t));
+            memcpy(&clientPrintResultsInterval, 
+                    packet.payload + sizeof(uint32_t) + sizeof(uint16_t) + sizeof(uint8_t), 
+                    sizeof(double));
+            memcpy(&printResultAccordingTimeClient, 
+                    packet.payload + sizeof(uint32_t) + sizeof(uint16_t) + sizeof(uint8_t) + sizeof(double), 
+                    sizeof(uint8_t));
+
+            clientTotalPrintResultsInterval = clientPrintResultsInterval;
+
+            if(!numberOfParallelStreams)
+                numberOfParallelStreams++;
+            
+            for(uint16_t ports = 0; ports < numberOfParallelStreams; ports++)
+                openPorts.push_back(++port);
+
+            //The client waits for its ports , so nothing else comes in between the exchanges
+            if(measureOneWay)
+                SyncClocks(CLOCK_SYNC_SAMPLES);
+
+            NerfPacket ports = NerfPacket::MakePortNumberPacket(port - numberOfParallelStreams + 1 , numberOfParallelStreams);
+
+            TCPSend(ports);
+        }break;
+    
+        case LAST_PACKET:
+        {
+            uint64_t lastUdpSeqNumber;
+            uint16_t port;
+
+            memcpy(&port, packet.payload, sizeof(uint16_t));
+            memcpy(&lastUdpSeqNumber, packet.payload + sizeof(uint16_t), sizeof(uint64_t));
+
+            //Every shard of the stream , the measurements take it into account once they are read
+            for(auto stream : totalParams)
+                if(stream->port == port)
+                    stream->lastSeqNumber.store(lastUdpSeqNumber , std::memory_order_relaxed);
+        }break;
+
+        case CLOCK:
+        {
+            Time     now;
+            uint64_t serverSend;
+            uint64_t clientRecv;
+            uint64_t clientSend;
+
+            SystemClock::GetSystemTime(&now);
+
+            memcpy(&serverSend, packet.payload,                          sizeof(uint64_t));
+            memcpy(&clientRecv, packet.payload + sizeof(uint64_t),       sizeof(uint64_t));
+            memcpy(&clientSend, packet.payload + (2 * sizeof(uint64_t)), sizeof(uint64_t));
+
+            clockSync.Push(serverSend , clientRecv , clientSend , SystemClock::GetTimeInNanoSeconds(&now));
+        }break;
+
+        case CLOSE:
+        {
+            //Remove Client
+            if(!isClientStop)
+                isClientStop = true;
+
+            //The drops up to the very end
+            SampleSockets();
+
+            SendPhaseMeasurements();
+            SendMeasurements();
+        }break;
+
+        default:
+        {
+        }break;
+    }
+}
+
+void Server::SampleSockets()
+{
+    std::vector<SocketMemory> sockets;
+    std::unordered_map<uint64_t , ServerStreamParams*> streams;
+
+    if(totalParams.empty() || !SocketOptions::GetUdpMemory(&sockets))
+        return;
+
+    for(auto params : totalParams)
+        streams[params->inode] = params;
+
+    for(auto& memory : sockets)
+    {
+        auto stream = streams.find(memory.inode);
+        if(stream == streams.end())
+            continue;
+
+        ServerStreamParams* params = stream->second;
+
+        //Dropped since the last sample , so the receiver fell behind by more than the buffer holds
+        if(memory.drops > params->diagDrops && memory.rcvbuf < socketBufferCap)
+            memory.rcvbuf = SocketOptions::GrowBuffer(params->socketId , true , std::min<uint64_t>((uint64_t)memory.rcvbuf * 2 , socketBufferCap));
+
+        params->diagDrops  = memory.drops;
+        params->rcvbuf     = memory.rcvbuf;
+        params->peakQueued = std::max(params->peakQueued , memory.queued);
+    }
+}
+
+void Server::GetMeasurementsForStream(uint32_t first , Measurements* streamMeasurements)
+{
+    ServerStreamSnapshot snapshot;
+    uint64_t packetsSent = 0;
+    uint64_t localDrops  = 0;
+    uint64_t lastSent    = totalParams[first]->lastSeqNumber.load(std::memory_order_relaxed);
+
+    for(uint32_t shard = first; shard < first + numberOfShards; shard++)
+    {
+        totalParams[shard]->snapshot.Read(&snapshot);
+
+        if(shard == first)
+            *streamMeasurements = snapshot.measurements;
+        else
+            Measurements::Combine(streamMeasurements , &snapshot.measurements);
+
+        //Every shard is a socket of its own
+        localDrops += std::max(snapshot.rxqDrops , totalParams[shard]->diagDrops);
+
+        //Every shard saw a part of the sequence , the gaps it saw are the datagrams of the other shards
+        packetsSent = std::max(packetsSent , snapshot.measurements.totalPacketsThatTheClientHaveSend);
+    }
+
+    streamMeasurements->localDrops = localDrops;
+
+    //The client said how many it sent (LAST_PACKET) , the ones past the last that arrived were lost too
+    if(lastSent)
+        packetsSent = lastSent;
+
+    streamMeasurements->totalPacketsThatTheClientHaveSend = packetsSent;
+    streamMeasurements->packetLost = (packetsSent > streamMeasurements->GetUniquePackets()) ? packetsSent - streamMeasurements->GetUniquePackets() : 0;
+}
+
+void Server::GetMeasurementsForEachStream()
+{
+    assert(totalParams.size() > 0);
+
+    //The histograms of the shards and the streams merge into one , exactly
+    if(measureOneWay)
+    {
+        GetMeasurementsForStream(0 , measurements);
+
+        latency->Reset();
+        wakeLatency[0]->Reset();
+        wakeLatency[1]->Reset();
+        for(auto params : totalParams)
+        {
+            latency->Merge(params->latency);
+            wakeLatency[0]->Merge(params->wakeLatency[0]);
+            wakeLatency[1]->Merge(params->wakeLatency[1]);
+        }
+        return;
+    }
+
+    std::vector<Measurements> streamMeasurements(totalParams.size() / numberOfShards);
+
+    //copy the measurements
+    for(uint32_t stream = 0; stream < streamMeasurements.size(); stream++)
+        GetMeasurementsForStream(stream * numberOfShards , &streamMeasurements[stream]);
+
+    ReduceTree(streamMeasurements.data() , streamMeasurements.size());
+
+    *measurements = streamMeasurements[0];
+}
+
+void Server::SendMeasurements()
+{
+    NerfPacket measurementsToSend;
+
+    //Cobine the measurements for each stream
+    GetMeasurementsForEachStream();
+
+    if(!measureOneWay)
+    {
+        measurementsToSend = NerfPacket::MakeMeasurementsPacket(0,
+                                                                measurements->GetThroughtput(),
+                                                                measurements->GetGoodput(),
+                                                                measurements->GetPacketLostPercentage(), 
+                                                                measurements->GetJitter(), 
+                                                                measurements->GetJitterStandardDeviation(),
+                                                                measurements->GetLocalLossPercentage());
+    }
+    else                                                                     
+    {
+        LatencySummary summary;
+
+        latency->GetSummary(&summary);
+        measurementsToSend = NerfPacket::MakeMeasurementsPacket(1 , summary , clockSync.GetError() / 1000000.0 , clockSync.GetSkew() * 1000000.0);
+    }
+
+    TCPSend(measurementsToSend);
+}
+
+// ======================================================================================================================================= 
+// ================================================== Clock Sync ========================================================================= 
+// =======================================================================================================================================
+
+void Server::SendClockProbe()
+{
+    Time now;
+
+    SystemClock::GetSystemTime(&now);
+
+    NerfPacket probe = NerfPacket::MakeClockPacket(SystemClock::GetTimeInNanoSeconds(&now) , 0 , 0);
+
+    TCPSend(probe);
+}
+
+void Server::SyncClocks(uint32_t samples)
+{
+    for(uint32_t sample = 0; sample < samples; sample++)
+    {
+        SendClockProbe();
+
+        if(TCPRecv() != CLOCK)
+        {
+            perror("[TCP SERVER ~ INFO] : the client did not answer the clock probe , the one way delays are not corrected");
+            return;
+        }
+    }
+}
+
+void Server::UpdateSkew()
+{
+    Time    now;
+    int64_t lowest = INT64_MAX;
+
+    for(auto params : totalParams)
+        lowest = std::min(lowest , params->minTransit.exchange(INT64_MAX , std::memory_order_relaxed));
+
+    //Nothing arrived in the window
+    if(lowest == INT64_MAX)
+        return;
+
+    SystemClock::GetSystemTime(&now);
+
+    //The middle of the window , from the start of the test
+    int64_t windowNano = (int64_t)SystemClock::GetTimeInNanoSeconds(&now) - (int64_t)intervalEpoch - (SKEW_WINDOW_NANO / 2);
+
+    skewEstimator.Push(windowNano / (double)ONE_SECOND_TO_NANO , lowest / (double)ONE_SECOND_TO_NANO);
+
+    //The transit times shrink as the clock of the client runs ahead of the one of the server
+    if(skewEstimator.GetPoints() >= SKEW_MIN_POINTS)
+        clockSync.SetSkew(-skewEstimator.GetSlope());
+}
+
+// ======================================================================================================================================= 
+// ================================================== Intervals ========================================================================== 
+// =======================================================================================================================================
+
+uint64_t Server::GetCurrentInterval()
+{
+    Time now;
+
+    SystemClock::GetSystemTime(&now);
+
+    return totalParams.empty() ? 0 : totalParams[0]->intervals.GetInterval(SystemClock::GetTimeInNanoSeconds(&now));
+}
+
+bool Server::GetIntervals(uint64_t first , uint64_t last , IntervalStats* stats)
+{
+    bool kept = true;
+
+    stats->Reset();
+
+    for(auto params : totalParams)
+        for(uint64_t interval = first; interval < last; interval++)
+            kept &= params->intervals.Get(interval , stats);
+
+    return kept;
+}
+
+void Server::UpdateEwma(uint64_t last)
+{
+    IntervalStats stats;
+    double duration = intervalNano / (double)ONE_SECOND_TO_NANO;
+    uint64_t retained = ((uint64_t)retention * ONE_SECOND_TO_NANO) / intervalNano;
+
+    //The intervals that the ring no longer holds are gone , the average starts over from the oldest one kept
+    if(last > ewmaInterval + retained)
+        ewmaInterval = last - retained;
+
+    for(; ewmaInterval < last; ewmaInterval++)
+    {
+        GetIntervals(ewmaInterval , ewmaInterval + 1 , &stats);
+
+        double rate = stats.GetThroughtput(duration);
+
+        ewmaThroughtput = ewmaInterval ? (EWMA_WEIGHT * rate) + ((1.0 - EWMA_WEIGHT) * ewmaThroughtput) : rate;
+    }
+}
+
+void Server::SendIntervalMeasurements()
+{
+    NerfPacket measurementsToSend;
+    IntervalStats stats;
+
+    //The percentiles of the one way delay are of the whole test
+    if(measureOneWay)
+    {
+        SendMeasurements();
+        return;
+    }
+
+    uint64_t last = GetCurrentInterval();
+    if(last <= clientReportInterval)
+        return;
+
+    double duration = ((last - clientReportInterval) * intervalNano) / (double)ONE_SECOND_TO_NANO;
+
+    GetIntervals(clientReportInterval , last , &stats);
+
+    //The drops of the sockets are counters since the start , only their growth belongs to the window
+    GetMeasurementsForEachStream();
+
+    uint64_t localDrops = measurements->localDrops - std::min(clientReportLocalDrops , measurements->localDrops);
+    double   localLoss  = stats.sent ? std::min((100.0 * localDrops) / stats.sent , 100.0) : 0.0;
+
+    measurementsToSend = NerfPacket::MakeMeasurementsPacket(0,
+                                                            stats.GetThroughtput(duration),
+                                                            stats.GetGoodput(duration),
+                                                            stats.GetPacketLostPercentage(),
+                                                            stats.GetJitter(),
+                                                            stats.GetJitterStandardDeviation(),
+                                                            localLoss);
+
+    clientReportInterval   = last;
+    clientReportLocalDrops = measurements->localDrops;
+
+    TCPSend(measurementsToSend);
+}
+
+// ======================================================================================================================================= 
+// ================================================== Profile Phases ===================================================================== 
+// =======================================================================================================================================
+
+uint32_t Server::GetPhase(Time* sendTime)
+{
+    uint64_t startTime = phasesStartTime;
+    uint64_t sent      = SystemClock::GetTimeInNanoSeconds(sendTime);
+
+    //Until the START packet is here , only the first phase can be on the wire
+    if(!startTime || sent <= startTime)
+        return 0;
+
+    //The last phase that started when the packet was sent , the phases are in order
+    auto next = std::upper_bound(phases.begin() , phases.end() , sent - startTime ,
+                                 [](uint64_t offset , const ServerPhase& phase) { return offset < phase.start; });
+
+    return (next == phases.begin()) ? 0 : (next - phases.begin()) - 1;
+}
+
+void Server::PushPhasePacket(ServerStreamParams* params , Time* sendTime , int64_t recvLen , uint64_t advanced , double dt , bool duplicate)
+{
+    uint32_t      phase  = GetPhase(sendTime);
+    Measurements* phaseMeasurements = &params->phaseMeasurements[phase];
+
+    params->dirtyPhases[phase] = 1;
+
+    phaseMeasurements->totalPackets++;
+    phaseMeasurements->duplicates += duplicate;
+    phaseMeasurements->totalBytesReceived    += recvLen;
+    phaseMeasurements->totalBytesReceivedWll += (recvLen + HEADERS_FROM_THE_LAYERS);
+
+    //The same RTP jitter , over the packets of the phase only
+    phaseMeasurements->PushJitter(dt);
+
+    //What the client sent in the phase is how far the highest sequence number moved in it
+    if(advanced)
+    {
+        phaseMeasurements->totalPacketsThatTheClientHaveSend += advanced;
+        params->lastPhase = phase;
+    }
+}
+
+void Server::GetMeasurementsForPhase(uint32_t phase , Measurements* phaseMeasurements)
+{
+    double duration = phases[phase].duration / (double)ONE_SECOND_TO_NANO;
+
+    ServerStreamSnapshot snapshot;
+    Measurements         shardMeasurements;
+
+    std::vector<Measurements> phaseStreams(totalParams.size() / numberOfShards);
+
+    for(uint32_t first = 0; first < totalParams.size(); first += numberOfShards)
+    {
+        Measurements& streamMeasurements = phaseStreams[first / numberOfShards];
+
+        uint64_t highestSeqNumber = 0;
+        uint32_t highestPhase     = 0;
+
+        //A single shard counted every packet that the client sent , as it moved the highest sequence number
+        for(uint32_t shard = first; shard < first + numberOfShards; shard++)
+        {
+            totalParams[shard]->phaseSnapshots[phase].Read(&shardMeasurements);
+            totalParams[shard]->snapshot.Read(&snapshot);
+
+            if(shard == first)
+                streamMeasurements = shardMeasurements;
+            else
+                Measurements::Combine(&streamMeasurements , &shardMeasurements);
+
+            if(snapshot.measurements.totalPacketsThatTheClientHaveSend > highestSeqNumber)
+            {
+                highestSeqNumber = snapshot.measurements.totalPacketsThatTheClientHaveSend;
+                highestPhase     = snapshot.lastPhase;
+            }
+        }
+
+        //The packets lost at the very end belong to the last phase
+        uint64_t lastSent = totalParams[first]->lastSeqNumber.load(std::memory_order_relaxed);
+
+        if(highestPhase == phase && lastSent > highestSeqNumber)
+            streamMeasurements.totalPacketsThatTheClientHaveSend += (lastSent - highestSeqNumber);
+
+        //Whatever was sent in the phase and never arrived
+        if(streamMeasurements.totalPacketsThatTheClientHaveSend > streamMeasurements.GetUniquePackets())
+            streamMeasurements.packetLost = streamMeasurements.totalPacketsThatTheClientHaveSend - streamMeasurements.GetUniquePackets();
+    }
+
+    ReduceTree(phaseStreams.data() , phaseStreams.size());
+
+    *phaseMeasurements = phaseStreams[0];
+
+    if(duration > 0)
+    {
+        phaseMeasurements->timeUntilNow       = duration;
+        phaseMeasurements->averageThroughtput = ((phaseMeasurements->totalBytesReceivedWll * 8) / duration) / 1000000.0;
+        phaseMeasurements->averageGoodput     = ((phaseMeasurements->totalBytesReceived * 8) / duration) / 1000000.0;
+    }
+}
+
+void Server::SendPhaseMeasurements()
+{
+    Measurements phaseMeasurements;
+
+    if(measureOneWay || totalParams.empty())
+        return;
+
+    for(uint32_t phase = 0; phase < phases.size(); phase++)
+    {
+        GetMeasurementsForPhase(phase , &phaseMeasurements);
+
+        NerfPacket measurementsToSend = NerfPacket::MakePhaseMeasurementsPacket(phase,
+                                                                                phaseMeasurements.GetThroughtput(),
+                                                                                phaseMeasurements.GetGoodput(),
+                                                                                phaseMeasurements.totalPacketsThatTheClientHaveSend ? phaseMeasurements.GetPacketLostPercentage() : 0.0,
+                                                                                phaseMeasurements.GetJitter(),
+                                                                                phaseMeasurements.GetJitterStandardDeviation());
+        TCPSend(measurementsToSend);
+    }
+}
+
+// ======================================================================================================================================= 
+// ======================================================= Run =========================================================================== 
+// ======================================================================================================================================= 
+
+void Server::RunServer()
+{
+    CreateReceivers();
+
+    for(auto port : openPorts)
+        CreateStream(port);
+
+    StartReceivers();
+
+    if(!controlLoop.Setup())
+    {
+        perror("[TCP SERVER ~ ERROR] : unable to create an event loop");
+        exit(0);
+    }
+
+    //Whatever ends the test stops every loop at once , no thread waits for a timeout
+    auto StopTest = [this]()
+    {
+        StopReceivers();
+        controlLoop.Stop();
+    };
+
+    //A client that went away without a CLOSE ends the test as well
+    controlLoop.Add(connectedClient , false , [this , StopTest]()
+    {
+        if(TCPRecv() == ERROR)
+            this->isClientStop = true;
+
+        if(this->isClientStop)
+            StopTest();
+
+        return true;
+    });
+
+    //The periodic reports , checked every tenth of the shortest interval (they are at most that late)
+    double reportInterval = 0.0;
+
+    if(printResultAccordingTime)
+        reportInterval = printResultsInterval;
+    if(printResultAccordingTimeClient && (!reportInterval || clientPrintResultsInterval < reportInterval))
+        reportInterval = clientPrintResultsInterval;
+
+    if(reportInterval > 0.0)
+    {
+        bool added = controlLoop.AddTimer(std::max<uint64_t>((reportInterval * ONE_SECOND_TO_NANO) / 10 , 1) , [this]()
+        {
+            double duration;
+
+            if(!startPrintData)
+                return true;
+
+            SystemClock::GetSystemTime(&nowTime);
+
+            diff = SystemClock::GetElapsedTime(&startTestTime , &nowTime);
+            duration = SystemClock::GetTimeInSeconds(&diff);
+            
+            // 0 == print results in the end
+            if(printResultAccordingTimeClient && duration >= clientTotalPrintResultsInterval)
+            {
+                clientTotalPrintResultsInterval += clientPrintResultsInterval;
+                SendIntervalMeasurements();
+            }
+
+            if(printResultAccordingTime && duration >= totalPrintResultsInterval)
+            {
+                totalPrintResultsInterval += printResultsInterval;
+                PrintResults();
+                PrintIntervals();
+            }
+
+            return true;
+        });
+
+        if(!added)
+            perror("[TCP SERVER ~ INFO] : unable to create the report timer");
+    }
+
+    //The clocks drift apart during a long test
+    if(measureOneWay && !controlLoop.AddTimer(CLOCK_SYNC_INTERVAL_NANO , [this]() { SendClockProbe(); return true; }))
+        perror("[TCP SERVER ~ INFO] : unable to create the clock sync timer");
+
+    if(measureOneWay && !controlLoop.AddTimer(SKEW_WINDOW_NANO , [this]() { UpdateSkew(); return true; }))
+        perror("[TCP SERVER ~ INFO] : unable to create the skew timer");
+
+    //The drops and the queues of the stream sockets
+    if(!controlLoop.AddTimer(SOCKET_SAMPLE_NANO , [this]() { SampleSockets(); return true; }))
+        perror("[TCP SERVER ~ INFO] : unable to create the socket sampling timer");
+
+    auto tcpHandler = [this]()
+    {   
+        affinity.PinControl();
+
+        if(!this->stopRunning)
+            controlLoop.Run();
+    };
+
+    std::thread tcpThread(tcpHandler);
+    tcpThread.join();
+
+    StopReceivers();
+
+    for(auto receiver : receivers)
+        receiver->thread->join();
+
+    controlLoop.Release();
+
+    //Print the final results for the server side
+    PrintResults();
+    PrintPhaseResults();
+
+    if(!heatmapFileName.empty())
+        WriteHeatmap();
+}
+
+void Server::Run()
+{
+    struct sockaddr_in clientAddr;
+    
+    uint32_t addrLen = sizeof(struct sockaddr_in);
+    int64_t recvLen;
+
+    while ( !stopRunning )
+    {
+        connectedClient = accept(socketTcpId , (struct sockaddr*)&clientAddr , &addrLen);
+        if(connectedClient >= 0)
+        {
+            fprintf(stdout, "\n[TCP SERVER ~ LOG] : connection from ( %s , %d ).\n", inet_ntoa(clientAddr.sin_addr),ntohs(clientAddr.sin_port));
+
+            //"nic" places the threads on the node of the interface that reaches the client
+            if(affinity.UsesNic())
+            {
+                std::string ifName;
+                int ifIndex;
+
+                if(SocketOptions::GetEgressInterface(&clientAddr , &ifIndex , &ifName))
+                    affinity.Resolve(ifName);
+                else
+                    fprintf(stderr, "[TCP SERVER ~ INFO] : unable to find the interface of the client , the \"nic\" threads are not pinned.\n");
+            }
+
+            //The datagrams come in through the interface that reaches the client , its NIC has to stamp them
+            if(rxTimestamps == RX_TIMESTAMP_HARDWARE)
+            {
+                std::string ifName;
+                int ifIndex;
+
+                if(!SocketOptions::GetEgressInterface(&clientAddr , &ifIndex , &ifName))
+                    fprintf(stderr, "[TCP SERVER ~ INFO] : unable to find the interface of the client , the arrival times come from the kernel.\n");
+                else
+                {
+                    bool changed;
+
+                    if(!SocketOptions::EnableHardwareRxTimestamps(ifName , &hwStampConfig , &changed))
+                        fprintf(stderr, "[TCP SERVER ~ INFO] : %s does not stamp the datagrams (%s) , the arrival times come from the kernel.\n", ifName.c_str(), strerror(errno));
+                    else if(changed)
+                        hwStampInterface = ifName;
+                }
+            }
+
+            uint8_t flags;
+
+            //A client may run several tests over the same connection (the throughput search) , one after the other
+            do
+            {
+                Reset();
+
+                //wait until will receive the SETUP packet from the client (the profile phases come first , and
+                //maybe the answer to the last clock probe of the test before)
+                while((flags = TCPRecv()) == PHASE || flags == CLOCK);
+
+                if(flags == SETUP)
+                    RunServer();
+            }while(flags == SETUP && !stopRunning);
+
+            RestoreHardwareRxTimestamps();
+        }
+
+        //close the connection 
+        close(connectedClient);
+    }
+}
+
+// ======================================================================================================================================= 
+// ==================================================== Print FUnctions ==================================================================
+// =======================================================================================================================================
 
 void Server::PrintResults()
 {
+    ServerStreamSnapshot snapshot;
+    uint64_t totalSyscalls = 0;
+
     //Compine the informations from the parallel streams
     GetMeasurementsForEachStream();
 
+    for(auto params : totalParams)
+    {
+        params->snapshot.Read(&snapshot);
+        totalSyscalls += snapshot.totalSyscalls;
+    }
+
+    for(auto receiver : receivers)
+        totalSyscalls += receiver->loopSyscalls.load(std::memory_order_relaxed) + receiver->ringSyscalls.load(std::memory_order_relaxed);
+
     if(!measureOneWay)
     {
         fprintf(resultsFile, "\nTotal Bytes Recv   :: %ld Bytes\n",   measurements->totalBytesReceived);
         fprintf(resultsFile, "Total Packets Recv :: %ld\n",           measurements->totalPackets);
+        fprintf(resultsFile, "Recv Syscalls      :: %ld\n",           totalSyscalls);
         fprintf(resultsFile, "Throughtput        :: %0.3lfMbits/s\n", measurements->GetThroughtput());
         fprintf(resultsFile, "Goodput            :: %0.3lfMbits/s\n", measurements->GetGoodput());
         fprintf(resultsFile, "Packet Lost        :: %0.2lf%%\n",      measurements->GetPacketLostPercentage());
+        fprintf(resultsFile, "   Network         :: %0.2lf%%\n",      measurements->GetNetworkLossPercentage());
+        fprintf(resultsFile, "   Local Receiver  :: %0.2lf%%\n",      measurements->GetLocalLossPercentage());
         fprintf(resultsFile, "Jitter             :: %0.2lfms\n",      measurements->GetJitter());
         fprintf(resultsFile, "Jitter Deviation   :: %0.6lf\n",        measurements->GetJitterStandardDeviation());
+        fprintf(resultsFile, "Reordered          :: %0.2lf%% , extent mean %0.2lf , max %ld\n",
+                measurements->GetReorderedPercentage(), measurements->GetMeanReorderExtent(), measurements->maxReorderExtent);
+        fprintf(resultsFile, "Duplicates         :: %ld\n",           measurements->duplicates);
+
+        PrintSocketMemory();
+        PrintRecvBatches();
+        PrintGro();
     }else 
-        fprintf(resultsFile, "One Way Delay  :: %0.2lfms\n", measurements->GetOneWayDelay());
+        PrintLatency();
+
+    PrintTimestamps();
+    PrintWakeLatency();
+}
+
+void Server::PrintLatency()
+{
+    LatencySummary summary;
+    Time           now;
+
+    latency->GetSummary(&summary);
+
+    fprintf(resultsFile, "One Way Delay      :: min %0.3lfms , mean %0.3lfms , max %0.3lfms (%ld datagrams)\n",
+            summary.min, summary.mean, summary.max, latency->GetCount());
+    fprintf(resultsFile, "   Percentiles     :: p50 %0.3lfms , p90 %0.3lfms , p99 %0.3lfms , p99.9 %0.3lfms\n",
+            summary.p50, summary.p90, summary.p99, summary.p999);
+
+    SystemClock::GetSystemTime(&now);
+
+    fprintf(resultsFile, "   Clock Offset    :: %0.3lfms +/- %0.3lfms (%u exchanges)\n",
+            clockSync.GetOffset(SystemClock::GetTimeInNanoSeconds(&now)) / 1000000.0, clockSync.GetError() / 1000000.0, clockSync.GetSamples());
+
+    //Not before enough windows
+    if(skewEstimator.GetPoints() >= SKEW_MIN_POINTS)
+        fprintf(resultsFile, "   Clock Skew      :: %0.3lfppm (fitted over %0.0lfs)\n",
+                clockSync.GetSkew() * 1000000.0, skewEstimator.GetSpan());
+}
+
+void Server::PrintIntervals()
+{
+    IntervalStats stats;
+    double   intervalSeconds = intervalNano / (double)ONE_SECOND_TO_NANO;
+    uint64_t last            = GetCurrentInterval();
+    uint64_t window          = std::max<uint64_t>(SLIDING_WINDOW_NANO / intervalNano , 1);
+
+    if(measureOneWay || last <= serverReportInterval)
+        return;
+
+    UpdateEwma(last);
+
+    double duration = (last - serverReportInterval) * intervalSeconds;
+
+    GetIntervals(serverReportInterval , last , &stats);
+    fprintf(resultsFile, "Interval           :: %0.2lf-%0.2lfs , %0.3lfMbits/s , lost %0.2lf%% , jitter %0.2lfms\n",
+            serverReportInterval * intervalSeconds, last * intervalSeconds,
+            stats.GetThroughtput(duration), stats.GetPacketLostPercentage(), stats.GetJitter());
+
+    uint64_t first = (last > window) ? last - window : 0;
+
+    duration = (last - first) * intervalSeconds;
+
+    GetIntervals(first , last , &stats);
+    fprintf(resultsFile, "Sliding Window     :: %0.2lfs , %0.3lfMbits/s , lost %0.2lf%% , jitter %0.2lfms\n",
+            duration, stats.GetThroughtput(duration), stats.GetPacketLostPercentage(), stats.GetJitter());
+    fprintf(resultsFile, "EWMA               :: %0.3lfMbits/s\n", ewmaThroughtput);
+
+    serverReportInterval = last;
+}
+
+void Server::WriteHeatmap()
+{
+    IntervalStats stats;
+    uint64_t last     = GetCurrentInterval() + 1;
+    uint64_t retained = ((uint64_t)retention * ONE_SECOND_TO_NANO) / intervalNano;
+    uint64_t first    = (last > retained) ? last - retained : 0;
+    bool     started  = false;
+
+    if(!measureOneWay || totalParams.empty())
+        return;
+
+    FILE* heatmapFile = fopen(heatmapFileName.c_str() , "a");
+    if(!heatmapFile)
+    {
+        perror("[UDP SERVER ~ INFO] : unable to open the heatmap file");
+        return;
+    }
+
+    //A header per test , then a line per interval : its start (s) and the datagrams of every latency bin
+    fprintf(heatmapFile, "# interval %0.3lfs , latency bins from (us) :", intervalNano / (double)ONE_SECOND_TO_NANO);
+    for(uint32_t bin = 0; bin < INTERVAL_LATENCY_BINS; bin++)
+        fprintf(heatmapFile, " %lu", IntervalStats::GetLatencyBinStart(bin));
+    fprintf(heatmapFile, "\n");
+
+    for(uint64_t interval = first; interval < last; interval++)
+    {
+        GetIntervals(interval , interval + 1 , &stats);
+
+        //Nothing before the first datagram
+        if(!started && !stats.packets)
+            continue;
+        started = true;
+
+        fprintf(heatmapFile, "%0.3lf", (interval * intervalNano) / (double)ONE_SECOND_TO_NANO);
+        for(uint32_t bin = 0; bin < INTERVAL_LATENCY_BINS; bin++)
+            fprintf(heatmapFile, " %lu", stats.latency[bin]);
+        fprintf(heatmapFile, "\n");
+    }
+
+    fprintf(heatmapFile, "\n");
+    fclose(heatmapFile);
+}
+
+void Server::PrintRecvBatches()
+{
+    ServerStreamSnapshot snapshot;
+    uint64_t recvBatches[RECV_BATCH_BUCKETS];
+    uint64_t totalBatches = 0;
+
+    if(recvBatchSize <= 1 || useIoUring)
+        return;
+
+    memset(recvBatches , 0 , sizeof(recvBatches));
+    for(auto params : totalParams)
+    {
+        params->snapshot.Read(&snapshot);
+
+        for(uint32_t bucket = 0; bucket < RECV_BATCH_BUCKETS; bucket++)
+        {
+            recvBatches[bucket] += snapshot.recvBatches[bucket];
+            totalBatches        += snapshot.recvBatches[bucket];
+        }
+    }
+
+    if(!totalBatches)
+        return;
+
+    //Full batches mean that the datagrams queue up faster than the receiver drains them
+    fprintf(resultsFile, "Recv Batches       :: %ld calls , %0.2lf datagrams per call\n", totalBatches, measurements->totalPackets / (double)totalBatches);
+    for(uint32_t bucket = 0; bucket < RECV_BATCH_BUCKETS; bucket++)
+    {
+        if(!recvBatches[bucket])
+            continue;
+
+        uint32_t first = (1 << bucket);
+        uint32_t last  = std::min<uint32_t>((first << 1) - 1 , recvBatchSize);
+
+        if(first == last)
+            fprintf(resultsFile, "   %4u            :: %0.2lf%%\n", first, (recvBatches[bucket] * 100.0) / totalBatches);
+        else
+            fprintf(resultsFile, "   %4u-%-4u       :: %0.2lf%%\n", first, last, (recvBatches[bucket] * 100.0) / totalBatches);
+    }
+}
+
+void Server::PrintGro()
+{
+    ServerStreamSnapshot snapshot;
+    uint64_t groBuffers   = 0;
+    uint64_t groDatagrams = 0;
+
+    if(!useGro || useIoUring)
+        return;
+
+    for(auto params : totalParams)
+    {
+        params->snapshot.Read(&snapshot);
+
+        groBuffers   += snapshot.groBuffers;
+        groDatagrams += snapshot.groDatagrams;
+    }
+
+    //Nothing is coalesced without a flow that comes in bursts (or a GSO sender on the same host)
+    fprintf(resultsFile, "GRO Buffers        :: %ld , %0.2lf datagrams each (%0.2lf%% of the datagrams)\n",
+            groBuffers,
+            groBuffers ? groDatagrams / (double)groBuffers : 0.0,
+            measurements->totalPackets ? (groDatagrams * 100.0) / measurements->totalPackets : 0.0);
+}
+
+void Server::PrintTimestamps()
+{
+    ServerStreamSnapshot snapshot;
+    uint64_t sources[RX_TIMESTAMP_SOURCES];
+    uint64_t totalPackets = 0;
+
+    memset(sources , 0 , sizeof(sources));
+    for(auto params : totalParams)
+    {
+        params->snapshot.Read(&snapshot);
+
+        totalPackets += snapshot.measurements.totalPackets;
+
+        for(uint8_t source = RX_TIMESTAMP_SOFTWARE; source < RX_TIMESTAMP_SOURCES; source++)
+            sources[source] += snapshot.rxTimestampSources[source];
+    }
+
+    if(rxTimestamps == RX_TIMESTAMP_USER || !totalPackets)
+    {
+        fprintf(resultsFile, "Arrival Times      :: user space (once the receive returned)\n");
+        return;
+    }
+
+    //Whatever the kernel did not stamp (io_uring , a NIC without the support) was timed in user space
+    sources[RX_TIMESTAMP_USER] = totalPackets - std::min(totalPackets , sources[RX_TIMESTAMP_SOFTWARE] + sources[RX_TIMESTAMP_HARDWARE]);
+
+    fprintf(resultsFile, "Arrival Times      :: NIC %0.2lf%% , kernel %0.2lf%% , user space %0.2lf%%\n",
+            (sources[RX_TIMESTAMP_HARDWARE] * 100.0) / totalPackets,
+            (sources[RX_TIMESTAMP_SOFTWARE] * 100.0) / totalPackets,
+            (sources[RX_TIMESTAMP_USER] * 100.0) / totalPackets);
+}
+
+void Server::PrintSocketMemory()
+{
+    uint32_t rcvbuf     = 0;
+    uint32_t peakQueued = 0;
+
+    for(auto params : totalParams)
+    {
+        rcvbuf     = std::max(rcvbuf , params->rcvbuf);
+        peakQueued = std::max(peakQueued , params->peakQueued);
+    }
+
+    //A queue that reached its buffer is what the local drops come from
+    fprintf(resultsFile, "Receive Buffer     :: %uKB , peak queue %uKB (sampled)\n", rcvbuf / 1024, peakQueued / 1024);
+}
+
+void Server::PrintWakeLatency()
+{
+    LatencySummary summary;
+    uint64_t       totalSleeps = 0;
+
+    if(!busyPollNano && !measureOneWay)
+        return;
+
+    for(auto receiver : receivers)
+        totalSleeps += receiver->loopSleeps.load(std::memory_order_relaxed);
+
+    //The datagrams that a sleeping receiver had to wake up for against the ones it found while it was spinning (or busy)
+    fprintf(resultsFile, "Receiver Sleeps    :: %ld\n", totalSleeps);
+
+    //Without -d the clocks are not synchronized , the latency would hold the offset between them
+    if(!measureOneWay)
+        return;
+
+    for(uint8_t woken = 0; woken < 2; woken++)
+    {
+        if(!wakeLatency[woken]->GetCount())
+            continue;
+
+        wakeLatency[woken]->GetSummary(&summary);
+
+        fprintf(resultsFile, "%s :: %ld datagrams , p50 %0.2lfus , p99 %0.2lfus , p99.9 %0.2lfus\n",
+                woken ? "Latency (Woken)   " : "Latency (Spinning)",
+                wakeLatency[woken]->GetCount(),
+                summary.p50 * 1000.0, summary.p99 * 1000.0, summary.p999 * 1000.0);
+    }
+}
+
+void Server::PrintPhaseResults()
+{
+    Measurements phaseMeasurements;
+
+    if(measureOneWay || totalParams.empty())
+        return;
+
+    for(uint32_t phase = 0; phase < phases.size(); phase++)
+    {
+        GetMeasurementsForPhase(phase , &phaseMeasurements);
+
+        fprintf(resultsFile, "\nPhase %-11u :: %s for %0.2lfs\n", phase + 1, phases[phase].description.c_str(), phases[phase].duration / (double)ONE_SECOND_TO_NANO);
+        fprintf(resultsFile, "Throughtput        :: %0.3lfMbits/s\n", phaseMeasurements.GetThroughtput());
+        fprintf(resultsFile, "Goodput            :: %0.3lfMbits/s\n", phaseMeasurements.GetGoodput());
+        fprintf(resultsFile, "Packet Lost        :: %0.2lf%%\n",      phaseMeasurements.totalPacketsThatTheClientHaveSend ? phaseMeasurements.GetPacketLostPercentage() : 0.0);
+        fprintf(resultsFile, "Jitter             :: %0.2lfms\n",      phaseMeasurements.GetJitter());
+        fprintf(resultsFile, "Jitter Deviation   :: %0.6lf\n",        phaseMeasurements.GetJitterStandardDeviation());
+    }
 }
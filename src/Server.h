@@ -4,23 +4,169 @@
 #include "Utilities.h"
 #include "NerfPacket.h"
 #include "Measurements.h"
+#include "Affinity.h"
+#include "IoUring.h"
+#include "EventLoop.h"
+#include "SocketOptions.h"
+#include "SeqLock.h"
+#include "ReorderWindow.h"
+#include "LatencyHistogram.h"
+#include "IntervalRing.h"
+#include "ClockSync.h"
+#include "SkewEstimator.h"
+
+#include <atomic>
+#include <new>
+#include <memory>
+#include <unordered_map>
 
 #define DEFAULT_PORT_SERVER               3742
 #define DEFAULT_IP_SERVER                 INADDR_ANY
 
+#define RECV_BATCH_BUCKETS                11      // 1 , 2-3 , 4-7 , ... , 1024 datagrams per recvmmsg
+#define RECV_CONTROL_LEN                  (GRO_CONTROL_LEN + TIMESTAMPING_CONTROL_LEN + RXQ_OVFL_CONTROL_LEN)
+
+#define DEFAULT_RECEIVER_THREADS          0       // one per core , never more than the streams
+#define RECEIVER_DRAIN_BUDGET             256     // datagrams a stream takes before the other streams of its thread get a turn
+
+#define DEFAULT_SHARDS                    1       // sockets per stream port
+#define DEFAULT_BUSY_POLL                 0       // the receivers sleep as soon as their sockets are empty
+
+#define SOCKET_BUFFER_INITIAL             4194304   // 4MB , SO_RCVBUF of a stream socket before it drops anything
+#define SOCKET_SAMPLE_NANO                100000000 // 100ms , sock_diag samples of the stream sockets
+#define MAX_SHARDS                        256
+
+#define SLIDING_WINDOW_NANO               1000000000 // 1s , the sliding window of the interval reports
+#define EWMA_WEIGHT                       0.2     // of the newest interval in the EWMA rate
+
+//A phase of the traffic profile of the client , the packets are reported per phase by their send time
+struct ServerPhase
+{
+    uint64_t    start;          // offset from the start of the client streams (ns)
+    uint64_t    duration;
+    std::string description;
+};
+
+//What the TCP thread sees of a stream , the receiver publishes it after every drain
+struct ServerStreamSnapshot
+{
+    Measurements      measurements;
+    uint32_t          lastPhase;
+    uint64_t          totalSyscalls;
+    uint64_t          recvBatches[RECV_BATCH_BUCKETS];
+    uint64_t          groBuffers;
+    uint64_t          groDatagrams;
+    uint64_t          rxTimestampSources[RX_TIMESTAMP_SOURCES];
+    uint32_t          rxqDrops;
+};
+
+//A socket of a stream. With SO_REUSEPORT shards a stream has several , each one gets a part of its datagrams.
+//
+//Every field has a single writer , and the fields of each writer sit on cache lines of their own. The TCP
+//thread reads the snapshots that the receiver publishes , never the counters it is updating.
 struct ServerStreamParams
 {
+    //Set up before the receivers start
     int socketId;
     uint16_t port;
-
+    uint16_t shard;
     uint32_t udpPacketSize;
-    uint64_t udpSeqNumber;
     uint8_t  measureOneWay;
+    uint64_t inode;
+
+    //The highest sequence number of the stream , shared by its shards (only with shards)
+    std::shared_ptr<std::atomic<uint64_t>> streamSeqNumber;
+
+    //The receiver thread
+    alignas(CACHE_LINE_SIZE) uint64_t udpSeqNumber;
+
+    //The sequence numbers that arrived lately , for the loss , the duplicates and the reordering
+    ReorderWindow reorderWindow;
 
     Measurements* measurements;
 
+    //The one way delay of every datagram (-d)
+    LatencyHistogram* latency;
+
+    //The last "retention" of intervals
+    IntervalRing intervals;
+
+    //One per phase of the traffic profile (if any) , and the phase of the highest sequence number
+    std::vector<Measurements> phaseMeasurements;
+    uint32_t lastPhase;
+
+    //recv (or recvmmsg) , the waits belong to the receiver
+    uint64_t totalSyscalls;
+
+    //recvmmsg calls by the number of datagrams they returned , in powers of two
+    uint64_t recvBatches[RECV_BATCH_BUCKETS];
+
+    //UDP_GRO buffers that carried more than a datagram , and the datagrams they carried
+    uint64_t groBuffers;
+    uint64_t groDatagrams;
+
+    //Datagrams by the source of their arrival time , the ones without a kernel or NIC stamp are left out
+    uint64_t rxTimestampSources[RX_TIMESTAMP_SOURCES];
+
+    //This is for jitter
+    double prevLatency;
+
+    //The SO_RXQ_OVFL counter of the last datagram
+    uint32_t rxqDrops;
+
+    //Whether the datagrams being drained came with a wakeup , and the one way delay of the ones found while
+    //the receiver was spinning [0] against the ones it woke up for [1] (-d)
+    bool              woken;
+    LatencyHistogram* wakeLatency[2];
+
+    //Changed since the last snapshot (io_uring publishes once per completion batch) , and the phases that did
+    bool                 dirty;
+    std::vector<uint8_t> dirtyPhases;
+
     Time startTime;
     Time nowTime;
+
+    //The receiver writes them , the TCP thread reads them
+    alignas(CACHE_LINE_SIZE) SeqLock<ServerStreamSnapshot> snapshot;
+    std::unique_ptr<SeqLock<Measurements>[]> phaseSnapshots;
+
+    //The lowest transit time (ns , the clock of the client) of the window of the skew , the TCP thread takes it
+    std::atomic<int64_t> minTransit;
+
+    //The TCP thread , the last sequence number that the client sent (LAST_PACKET) and what sock_diag saw
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> lastSeqNumber;
+    uint32_t diagDrops;
+    uint32_t rcvbuf;
+    uint32_t peakQueued;
+
+    //Plain new aligns to 16 bytes only (before C++17)
+    static void* operator new(size_t size)
+    {
+        void* pointer;
+
+        if(posix_memalign(&pointer , CACHE_LINE_SIZE , size))
+            throw std::bad_alloc();
+
+        return pointer;
+    }
+
+    static void operator delete(void* pointer)
+    {
+        free(pointer);
+    }
+};
+
+//A receiver thread and the streams whose sockets it waits on
+struct ServerReceiver
+{
+    std::thread* thread;
+    EventLoop    loop;
+    std::vector<ServerStreamParams*> streams;
+
+    //io_uring_enter , and the epoll_wait of the loop , published with the snapshots of the streams
+    std::atomic<uint64_t> ringSyscalls;
+    std::atomic<uint64_t> loopSyscalls;
+    std::atomic<uint64_t> loopSleeps;
 };
 
 class Server
@@ -34,8 +180,69 @@ private:
     //state
     bool startPrintData;
 
-    //Measurements
-    Measurements* measurements;
+    //Measurements , and the one way delays of every stream merged (all of them , then spinning and woken)
+    Measurements*     measurements;
+    LatencyHistogram* latency;
+    LatencyHistogram* wakeLatency[2];
+
+    //Traffic profile of the client , the start time is in the clock of the client (0 until the START packet)
+    std::vector<ServerPhase> phases;
+    std::atomic<uint64_t>    phasesStartTime;
+
+    //Where the receiver threads and the TCP thread run
+    Affinity affinity;
+
+    //Receive with a multishot recv on an io_uring instead of select + recvfrom
+    uint8_t useIoUring;
+
+    //Datagrams that a recvmmsg call may return (1 , a recv per datagram)
+    uint32_t recvBatchSize;
+
+    //Let the kernel coalesce the datagrams of a stream (UDP_GRO) , the receivers split them again
+    uint8_t useGro;
+
+    //Where the arrival times come from , RX_TIMESTAMP_USER for clock_gettime after the receive
+    uint8_t rxTimestamps;
+
+    //The interface whose NIC we turned the stamps on for (empty if none) , and what it did before
+    std::string            hwStampInterface;
+    struct hwtstamp_config hwStampConfig;
+
+    //SO_REUSEPORT sockets per stream port , steered by the CPU that received the datagram or by the flow hash
+    uint16_t numberOfShards;
+    bool     shardByCpu;
+
+    //SO_RCVBUF of a stream socket doubles whenever it drops , up to this
+    uint32_t socketBufferCap;
+
+    //How long (ns) a receiver spins on its empty sockets before it sleeps
+    uint64_t busyPollNano;
+
+    //The offset of the clock of the client (-d) , the send times of the datagrams are read on the clock of the server
+    ClockSync clockSync;
+
+    //How fast the clock of the client drifts , from the lowest transit times of every window (-d)
+    SkewEstimator skewEstimator;
+
+    //The intervals of the streams , every one "intervalNano" long from "intervalEpoch" on , for "retention" seconds
+    uint64_t    intervalNano;
+    uint32_t    retention;
+    uint64_t    intervalEpoch;
+    std::string heatmapFileName;
+
+    //The first interval that the next server (-i) and client report starts with , and the one the EWMA is up to
+    uint64_t serverReportInterval;
+    uint64_t clientReportInterval;
+    uint64_t clientReportLocalDrops;
+    uint64_t ewmaInterval;
+    double   ewmaThroughtput;
+
+    //The streams are spread over a fixed pool of receiver threads , one epoll loop each
+    uint32_t numberOfReceiverThreads;
+    std::vector<ServerReceiver*> receivers;
+
+    //The TCP connection and the periodic reports
+    EventLoop controlLoop;
 
     //Internal variables
     uint32_t udpPacketSize;
@@ -63,13 +270,9 @@ private:
     //Bind , accept variables
     struct sockaddr_in bindTcpPort;
 
-    //File descriptors set
-    int maxFd;
-    fd_set readDescriptors;
-
-    //State
-    bool stopRunning;
-    bool isClientStop;
+    //State , a stop may come from the SIGINT handler
+    std::atomic<bool> stopRunning;
+    bool              isClientStop;
 
     //Files
     FILE* resultsFile;
@@ -79,7 +282,6 @@ private:
     std::vector<int>                 openSockets;
     std::vector<struct sockaddr_in>  bindUdpAddresses;
     std::vector<ServerStreamParams*> totalParams;
-    std::vector<std::thread*>        openStreams;
 
 public:
     // ======================================================================================================================================= 
@@ -105,12 +307,40 @@ public:
     void Reset();
 
     void CleanUp();
+
+    //Puts the NIC stamps back to what they were before the connection (they are for the whole host)
+    void RestoreHardwareRxTimestamps();
     
     void SetVariables(uint8_t _printInFile, 
                       std::string _resultsFileName,
                       uint8_t _printResultAccordingTime,
                       double  _printResultsInterval);
 
+    void SetAffinity(const Affinity& _affinity);
+
+    void SetIoUring(uint8_t _useIoUring);
+
+    void SetRecvBatchSize(uint32_t _recvBatchSize);
+
+    void SetGro(uint8_t _useGro);
+
+    void SetRxTimestamps(uint8_t _rxTimestamps);
+
+    void SetReceiverThreads(uint32_t _numberOfReceiverThreads);
+
+    void SetShards(uint16_t _numberOfShards , bool _shardByCpu);
+
+    //Intervals of "_intervalMilli" , "_retention" seconds of them per stream
+    void SetIntervals(uint32_t _intervalMilli , uint32_t _retention);
+
+    //Writes the time x latency heatmap of every test to "_heatmapFileName"
+    void SetHeatmap(std::string _heatmapFileName);
+
+    void SetSocketBufferCap(uint32_t _socketBufferCap);
+
+    //After the affinity , a spinning receiver wants a core of its own
+    void SetBusyPoll(uint64_t _busyPollNano);
+
     void StopRunning();
     
     // ======================================================================================================================================= 
@@ -121,22 +351,93 @@ public:
 
     ServerStreamParams* CreateUdpServer(uint16_t portNo);
 
+    void CreateReceivers();
+
     void CreateStream(uint16_t portNo);
 
+    //Every receiver thread has allocated the measurements of its streams once this returns
+    void StartReceivers();
+
+    void StopReceivers();
+
+    // ======================================================================================================================================= 
+    // ==================================================== Receivers ======================================================================== 
+    // ======================================================================================================================================= 
+
+    //Everything we learn from a datagram of "recvLen" bytes that arrived at "arriveTime" , whichever backend received it
+    void PushPacket(ServerStreamParams* params , uint8_t* packet , int64_t recvLen , Time* arriveTime);
+
+    //The snapshots of the stream (and of the phases it changed) for the TCP thread
+    void PublishStream(ServerReceiver* receiver , ServerStreamParams* params);
+
+    //Drains the sockets of the receiver whenever epoll says they are readable
+    void RunReceiver(ServerReceiver* receiver);
+
+    //A multishot recv per stream on a single ring , false if the ring can not be set up
+    bool RunReceiverIoUring(ServerReceiver* receiver);
+
     // ======================================================================================================================================= 
     // ==================================================== TCP functions ==================================================================== 
     // =======================================================================================================================================
     
     void TCPSend(NerfPacket& packet);
 
-    void TCPRecv();
+    uint8_t TCPRecv();
 
     void ParsePacket(NerfPacket& packet);
 
+    //sock_diag over the stream sockets , the ones that dropped get a larger receive buffer
+    void SampleSockets();
+
+    //The shards of the stream that starts at "first" in totalParams , merged (from their snapshots)
+    void GetMeasurementsForStream(uint32_t first , Measurements* streamMeasurements);
+
     void GetMeasurementsForEachStream();
 
     void SendMeasurements();
 
+    // ======================================================================================================================================= 
+    // ================================================== Clock Sync ========================================================================= 
+    // =======================================================================================================================================
+
+    //The client answers with its clock , the answer comes back through ParsePacket
+    void SendClockProbe();
+
+    //"samples" exchanges one after the other , before the client has anything else to send
+    void SyncClocks(uint32_t samples);
+
+    //The lowest transit time of the window that ended now goes into the fit , the offset drifts with its skew
+    void UpdateSkew();
+
+    // ======================================================================================================================================= 
+    // ================================================== Intervals ========================================================================== 
+    // =======================================================================================================================================
+
+    //The interval that is going on now , the ones before it are over
+    uint64_t GetCurrentInterval();
+
+    //The intervals [first , last) of every stream added up , false if some are no longer kept
+    bool GetIntervals(uint64_t first , uint64_t last , IntervalStats* stats);
+
+    //The EWMA rate , over every interval before "last"
+    void UpdateEwma(uint64_t last);
+
+    //What arrived since the last client report , instead of the averages since the start
+    void SendIntervalMeasurements();
+
+    // ======================================================================================================================================= 
+    // ================================================== Profile Phases ===================================================================== 
+    // =======================================================================================================================================
+
+    uint32_t GetPhase(Time* sendTime);
+
+    //"advanced" how far the packet moved the highest sequence number of the stream
+    void PushPhasePacket(ServerStreamParams* params , Time* sendTime , int64_t recvLen , uint64_t advanced , double dt , bool duplicate);
+
+    void GetMeasurementsForPhase(uint32_t phase , Measurements* phaseMeasurements);
+
+    void SendPhaseMeasurements();
+
     // ======================================================================================================================================= 
     // ======================================================= Run =========================================================================== 
     // ======================================================================================================================================= 
@@ -150,6 +451,27 @@ public:
     // =======================================================================================================================================
 
     void PrintResults();
+
+    //The one way delays (-d) , merged over the streams
+    void PrintLatency();
+
+    //The interval since the last report , the sliding window and the EWMA rate
+    void PrintIntervals();
+
+    //Every interval still kept , a line per interval with its datagrams per latency bin
+    void WriteHeatmap();
+
+    void PrintRecvBatches();
+
+    void PrintGro();
+
+    void PrintTimestamps();
+
+    void PrintWakeLatency();
+
+    void PrintSocketMemory();
+
+    void PrintPhaseResults();
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include "SkewEstimator.h"
+
+SkewEstimator::SkewEstimator()
+{
+    Reset();
+}
+
+void SkewEstimator::Reset()
+{
+    hull.clear();
+    numberOfPoints = 0;
+    totalTime      = 0.0f;
+    firstTime      = 0.0f;
+    lastTime       = 0.0f;
+}
+
+void SkewEstimator::Push(double time , double transit)
+{
+    Point point = {time , transit};
+
+    if(!numberOfPoints)
+        firstTime = time;
+
+    numberOfPoints++;
+    totalTime += time;
+    lastTime   = time;
+
+    //Two windows at the same time (a timer that ran late) , the lower one is the one that counts
+    if(!hull.empty() && hull.back().time >= time)
+    {
+        if(hull.back().transit <= transit)
+            return;
+        hull.pop_back();
+    }
+
+    //Andrew's monotone chain , a point that the new one sees from below is no longer on the lower envelope
+    while(hull.size() >= 2)
+    {
+        const Point& first  = hull[hull.size() - 2];
+        const Point& second = hull[hull.size() - 1];
+
+        double cross = ((second.time - first.time) * (point.transit - first.transit)) -
+                       ((second.transit - first.transit) * (point.time - first.time));
+
+        if(cross > 0.0)
+            break;
+
+        hull.pop_back();
+    }
+
+    hull.push_back(point);
+}
+
+double SkewEstimator::GetSlope()
+{
+    if(numberOfPoints < SKEW_MIN_POINTS || hull.size() < 2)
+        return 0.0;
+
+    double meanTime = totalTime / numberOfPoints;
+
+    //The first edge that ends past the mean , the hull is sorted by time
+    uint32_t low  = 1;
+    uint32_t high = hull.size() - 1;
+
+    while(low < high)
+    {
+        uint32_t middle = (low + high) / 2;
+
+        if(hull[middle].time < meanTime)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    const Point& first  = hull[low - 1];
+    const Point& second = hull[low];
+
+    return (second.transit - first.transit) / (second.time - first.time);
+}
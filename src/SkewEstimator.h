@@ -0,0 +1,54 @@
+#ifndef _SKEW_ESTIMATOR_H_
+#define _SKEW_ESTIMATOR_H_
+
+#include "Utilities.h"
+
+#define SKEW_WINDOW_NANO        1000000000  // 1s , a point of the fit is the lowest transit time of every window
+#define SKEW_MIN_POINTS         10          // windows before the skew is estimated (and applied)
+
+//The rate that the clock of the client drifts at , from the transit times of the datagrams (Moon , Skelly and
+//Towsley). The queues only ever add to a transit time , so the lowest ones follow the line of the drift. The fit is
+//the line under every point that is closest to them all (their sum of distances) : the edge of the lower convex
+//hull of the points over the mean of their times.
+//
+//A point per window keeps it online and small , the hull is built as they come (in time order) and only
+//holds the points of its lower envelope.
+class SkewEstimator
+{
+private:
+    struct Point
+    {
+        double time;      // seconds
+        double transit;   // seconds
+    };
+
+    std::vector<Point> hull;
+    uint64_t numberOfPoints;
+    double   totalTime;
+    double   firstTime;
+    double   lastTime;
+
+public:
+    SkewEstimator();
+
+    void Reset();
+
+    //"time" never goes back
+    void Push(double time , double transit);
+
+    //How fast the lowest transit times grow (seconds per second) , 0 until there are enough points
+    double GetSlope();
+
+    inline uint64_t GetPoints()
+    {
+        return numberOfPoints;
+    }
+
+    //How long (seconds) the points span
+    inline double GetSpan()
+    {
+        return numberOfPoints ? lastTime - firstTime : 0.0;
+    }
+};
+
+#endif
@@ -0,0 +1,476 @@
+#include "SocketOptions.h"
+
+#include <ifaddrs.h>
+#include <netinet/udp.h>
+#include <net/if.h>
+#include <linux/filter.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/errqueue.h>
+#include <linux/sock_diag.h>
+#include <linux/inet_diag.h>
+#include <sys/stat.h>
+#include <linux/sockios.h>
+#include <sys/ioctl.h>
+
+// =======================================================================================================================================
+// ================================================== Interfaces / Qdiscs ================================================================
+// =======================================================================================================================================
+
+bool SocketOptions::GetEgressInterface(struct sockaddr_in* destination , int* ifIndex , std::string* ifName)
+{
+    struct sockaddr_in source;
+    struct ifaddrs*    interfaces;
+
+    socklen_t sourceLen = sizeof(struct sockaddr_in);
+    bool      found     = false;
+
+    //Connecting a scratch UDP socket makes the kernel pick the route (and the source address) for us
+    int socketId = socket(AF_INET , SOCK_DGRAM , 0);
+    if(socketId < 0)
+        return false;
+
+    if(connect(socketId , (struct sockaddr*)destination , sizeof(struct sockaddr_in)) ||
+       getsockname(socketId , (struct sockaddr*)&source , &sourceLen))
+    {
+        close(socketId);
+        return false;
+    }
+    close(socketId);
+
+    if(getifaddrs(&interfaces))
+        return false;
+
+    for(struct ifaddrs* interface = interfaces; interface; interface = interface->ifa_next)
+    {
+        if(!interface->ifa_addr || interface->ifa_addr->sa_family != AF_INET)
+            continue;
+
+        if(((struct sockaddr_in*)interface->ifa_addr)->sin_addr.s_addr == source.sin_addr.s_addr)
+        {
+            *ifName  = interface->ifa_name;
+            *ifIndex = if_nametoindex(interface->ifa_name);
+            found    = (*ifIndex > 0);
+            break;
+        }
+    }
+    freeifaddrs(interfaces);
+
+    return found;
+}
+
+std::vector<std::string> SocketOptions::GetQdiscs(int ifIndex)
+{
+    std::vector<std::string> qdiscs;
+
+    struct
+    {
+        struct nlmsghdr header;
+        struct tcmsg    tc;
+    } request;
+
+    uint8_t buffer[16384];
+    bool    done = false;
+
+    int socketId = socket(AF_NETLINK , SOCK_RAW , NETLINK_ROUTE);
+    if(socketId < 0)
+        return qdiscs;
+
+    memset(&request , 0 , sizeof(request));
+    request.header.nlmsg_len   = NLMSG_LENGTH(sizeof(struct tcmsg));
+    request.header.nlmsg_type  = RTM_GETQDISC;
+    request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.tc.tcm_family      = AF_UNSPEC;
+
+    if(send(socketId , &request , request.header.nlmsg_len , 0) < 0)
+    {
+        close(socketId);
+        return qdiscs;
+    }
+
+    while(!done)
+    {
+        int64_t recvLen = recv(socketId , buffer , sizeof(buffer) , 0);
+        if(recvLen <= 0)
+            break;
+
+        for(struct nlmsghdr* header = (struct nlmsghdr*)buffer; NLMSG_OK(header , recvLen); header = NLMSG_NEXT(header , recvLen))
+        {
+            if(header->nlmsg_type == NLMSG_DONE || header->nlmsg_type == NLMSG_ERROR)
+            {
+                done = true;
+                break;
+            }
+
+            struct tcmsg* tc = (struct tcmsg*)NLMSG_DATA(header);
+            if(tc->tcm_ifindex != ifIndex)
+                continue;
+
+            int attributesLen = header->nlmsg_len - NLMSG_LENGTH(sizeof(struct tcmsg));
+            for(struct rtattr* attribute = TCA_RTA(tc); RTA_OK(attribute , attributesLen); attribute = RTA_NEXT(attribute , attributesLen))
+                if(attribute->rta_type == TCA_KIND)
+                    qdiscs.push_back(std::string((const char*)RTA_DATA(attribute)));
+        }
+    }
+
+    close(socketId);
+    return qdiscs;
+}
+
+bool SocketOptions::HasQdisc(int ifIndex , const char* kind)
+{
+    //On multiqueue devices the root is "mq" and the real qdiscs hang below it , so look at all of them
+    for(auto& qdisc : GetQdiscs(ifIndex))
+        if(qdisc == kind)
+            return true;
+    return false;
+}
+
+// =======================================================================================================================================
+// ================================================== Pacing =============================================================================
+// =======================================================================================================================================
+
+bool SocketOptions::SetMaxPacingRate(int socketId , uint64_t bytesPerSecond)
+{
+    //Recent kernels take a 64bit rate , older ones only the 32bit one
+    if(!setsockopt(socketId , SOL_SOCKET , SO_MAX_PACING_RATE , &bytesPerSecond , sizeof(uint64_t)))
+        return true;
+
+    uint32_t bytesPerSecond32 = std::min<uint64_t>(bytesPerSecond , UINT32_MAX);
+
+    return !setsockopt(socketId , SOL_SOCKET , SO_MAX_PACING_RATE , &bytesPerSecond32 , sizeof(uint32_t));
+}
+
+bool SocketOptions::SetTxTime(int socketId , clockid_t clock)
+{
+    struct sock_txtime txTime;
+
+    txTime.clockid = clock;
+    txTime.flags   = 0;
+
+    return !setsockopt(socketId , SOL_SOCKET , SO_TXTIME , &txTime , sizeof(struct sock_txtime));
+}
+
+// =======================================================================================================================================
+// ================================================== Offloads ===========================================================================
+// =======================================================================================================================================
+
+bool SocketOptions::SetUdpSegment(int socketId , uint16_t segmentSize)
+{
+    //Every send larger than "segmentSize" is split by the kernel (or the NIC) into datagrams of "segmentSize"
+    int size = segmentSize;
+
+    return !setsockopt(socketId , SOL_UDP , UDP_SEGMENT , &size , sizeof(int));
+}
+
+bool SocketOptions::SetZeroCopy(int socketId)
+{
+    //Only allows MSG_ZEROCOPY on the socket , every send still asks for it
+    int enable = 1;
+
+    return !setsockopt(socketId , SOL_SOCKET , SO_ZEROCOPY , &enable , sizeof(int));
+}
+
+bool SocketOptions::SetUdpGro(int socketId)
+{
+    int enable = 1;
+
+    return !setsockopt(socketId , SOL_UDP , UDP_GRO , &enable , sizeof(int));
+}
+
+uint16_t SocketOptions::GetGroSegmentSize(struct msghdr* header)
+{
+    for(struct cmsghdr* control = CMSG_FIRSTHDR(header); control; control = CMSG_NXTHDR(header , control))
+    {
+        if(control->cmsg_level == SOL_UDP && control->cmsg_type == UDP_GRO)
+        {
+            int segmentSize;
+
+            memcpy(&segmentSize , CMSG_DATA(control) , sizeof(int));
+            return segmentSize;
+        }
+    }
+
+    return 0;
+}
+
+// =======================================================================================================================================
+// ================================================== Receive Shards =====================================================================
+// =======================================================================================================================================
+
+bool SocketOptions::SetReusePort(int socketId)
+{
+    int enable = 1;
+
+    return !setsockopt(socketId , SOL_SOCKET , SO_REUSEPORT , &enable , sizeof(int));
+}
+
+bool SocketOptions::SetCpuSteering(int socketId , uint16_t groupSize)
+{
+    //A classic BPF program is enough , A = cpu % groupSize is the index of the socket
+    struct sock_filter code[] =
+    {
+        { BPF_LD  | BPF_W | BPF_ABS , 0 , 0 , (uint32_t)(SKF_AD_OFF + SKF_AD_CPU) },
+        { BPF_ALU | BPF_MOD | BPF_K , 0 , 0 , groupSize },
+        { BPF_RET | BPF_A           , 0 , 0 , 0 },
+    };
+    struct sock_fprog program;
+
+    program.len    = sizeof(code) / sizeof(struct sock_filter);
+    program.filter = code;
+
+    return !setsockopt(socketId , SOL_SOCKET , SO_ATTACH_REUSEPORT_CBPF , &program , sizeof(struct sock_fprog));
+}
+
+// =======================================================================================================================================
+// ================================================== Timestamps =========================================================================
+// =======================================================================================================================================
+
+bool SocketOptions::SetRxTimestamping(int socketId , bool hardware)
+{
+    //The software stamp is always asked for , it covers the datagrams that the NIC did not stamp
+    int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+
+    if(hardware)
+        flags |= SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+
+    return !setsockopt(socketId , SOL_SOCKET , SO_TIMESTAMPING , &flags , sizeof(int));
+}
+
+bool SocketOptions::EnableHardwareRxTimestamps(const std::string& ifName , struct hwtstamp_config* previous , bool* changed)
+{
+    struct hwtstamp_config config;
+    struct ifreq           request;
+
+    *changed = false;
+
+    int socketId = socket(AF_INET , SOCK_DGRAM , 0);
+    if(socketId < 0)
+        return false;
+
+    memset(&request , 0 , sizeof(struct ifreq));
+    strncpy(request.ifr_name , ifName.c_str() , IFNAMSIZ - 1);
+    request.ifr_data = (char*)previous;
+
+    //Off , unless the driver tells us otherwise
+    memset(previous , 0 , sizeof(struct hwtstamp_config));
+    previous->tx_type   = HWTSTAMP_TX_OFF;
+    previous->rx_filter = HWTSTAMP_FILTER_NONE;
+
+    //Someone (ptp4l) may already stamp a part of the traffic , that is not ours to change
+    if(!ioctl(socketId , SIOCGHWTSTAMP , &request) && previous->rx_filter == HWTSTAMP_FILTER_ALL)
+    {
+        close(socketId);
+        return true;
+    }
+
+    //The transmit side stays as it was
+    config           = *previous;
+    config.rx_filter = HWTSTAMP_FILTER_ALL;
+    request.ifr_data = (char*)&config;
+
+    bool enabled = !ioctl(socketId , SIOCSHWTSTAMP , &request);
+
+    close(socketId);
+
+    *changed = enabled;
+
+    return enabled;
+}
+
+bool SocketOptions::RestoreHardwareRxTimestamps(const std::string& ifName , const struct hwtstamp_config* previous)
+{
+    struct hwtstamp_config config = *previous;
+    struct ifreq           request;
+
+    int socketId = socket(AF_INET , SOCK_DGRAM , 0);
+    if(socketId < 0)
+        return false;
+
+    memset(&request , 0 , sizeof(struct ifreq));
+    strncpy(request.ifr_name , ifName.c_str() , IFNAMSIZ - 1);
+    request.ifr_data = (char*)&config;
+
+    bool restored = !ioctl(socketId , SIOCSHWTSTAMP , &request);
+
+    close(socketId);
+
+    return restored;
+}
+
+uint8_t SocketOptions::GetRxTimestamp(struct msghdr* header , Time* stamp)
+{
+    for(struct cmsghdr* control = CMSG_FIRSTHDR(header); control; control = CMSG_NXTHDR(header , control))
+    {
+        if(control->cmsg_level == SOL_SOCKET && control->cmsg_type == SO_TIMESTAMPING)
+        {
+            struct scm_timestamping stamps;
+
+            memcpy(&stamps , CMSG_DATA(control) , sizeof(struct scm_timestamping));
+
+            //The raw hardware stamp is the third one , the software one the first
+            if(stamps.ts[2].tv_sec || stamps.ts[2].tv_nsec)
+            {
+                *stamp = stamps.ts[2];
+                return RX_TIMESTAMP_HARDWARE;
+            }
+
+            if(stamps.ts[0].tv_sec || stamps.ts[0].tv_nsec)
+            {
+                *stamp = stamps.ts[0];
+                return RX_TIMESTAMP_SOFTWARE;
+            }
+        }
+    }
+
+    return RX_TIMESTAMP_USER;
+}
+
+// =======================================================================================================================================
+// ================================================== Busy Polling =======================================================================
+// =======================================================================================================================================
+
+bool SocketOptions::SetBusyPoll(int socketId , uint32_t usec)
+{
+    int value  = usec;
+    int prefer = 1;
+
+    if(setsockopt(socketId , SOL_SOCKET , SO_BUSY_POLL , &value , sizeof(int)))
+        return false;
+
+    //Older kernels do not know it , the busy poll works without it
+    setsockopt(socketId , SOL_SOCKET , SO_PREFER_BUSY_POLL , &prefer , sizeof(int));
+
+    return true;
+}
+
+// =======================================================================================================================================
+// ================================================== Socket Memory ======================================================================
+// =======================================================================================================================================
+
+bool SocketOptions::SetRxQueueOverflow(int socketId)
+{
+    int enable = 1;
+
+    return !setsockopt(socketId , SOL_SOCKET , SO_RXQ_OVFL , &enable , sizeof(int));
+}
+
+bool SocketOptions::GetRxQueueOverflow(struct msghdr* header , uint32_t* drops)
+{
+    for(struct cmsghdr* control = CMSG_FIRSTHDR(header); control; control = CMSG_NXTHDR(header , control))
+    {
+        if(control->cmsg_level == SOL_SOCKET && control->cmsg_type == SO_RXQ_OVFL)
+        {
+            memcpy(drops , CMSG_DATA(control) , sizeof(uint32_t));
+            return true;
+        }
+    }
+
+    return false;
+}
+
+uint32_t SocketOptions::GrowBuffer(int socketId , bool receive , uint32_t bytes)
+{
+    int       size;
+    int       wanted  = bytes / 2;
+    socklen_t sizeLen = sizeof(int);
+
+    if(getsockopt(socketId , SOL_SOCKET , receive ? SO_RCVBUF : SO_SNDBUF , &size , &sizeLen))
+        return 0;
+
+    if((uint32_t)size >= bytes)
+        return size;
+
+    //The forced one ignores the system wide limit , but only for the administrator
+    if(setsockopt(socketId , SOL_SOCKET , receive ? SO_RCVBUFFORCE : SO_SNDBUFFORCE , &wanted , sizeof(int)))
+        setsockopt(socketId , SOL_SOCKET , receive ? SO_RCVBUF : SO_SNDBUF , &wanted , sizeof(int));
+
+    sizeLen = sizeof(int);
+    if(getsockopt(socketId , SOL_SOCKET , receive ? SO_RCVBUF : SO_SNDBUF , &size , &sizeLen))
+        return 0;
+
+    return size;
+}
+
+uint64_t SocketOptions::GetInode(int socketId)
+{
+    struct stat status;
+
+    if(fstat(socketId , &status))
+        return 0;
+
+    return status.st_ino;
+}
+
+bool SocketOptions::GetUdpMemory(std::vector<SocketMemory>* sockets)
+{
+    struct
+    {
+        struct nlmsghdr           header;
+        struct inet_diag_req_v2   diag;
+    } request;
+
+    uint8_t buffer[16384];
+    bool    done = false;
+
+    int socketId = socket(AF_NETLINK , SOCK_RAW | SOCK_CLOEXEC , NETLINK_SOCK_DIAG);
+    if(socketId < 0)
+        return false;
+
+    memset(&request , 0 , sizeof(request));
+    request.header.nlmsg_len    = sizeof(request);
+    request.header.nlmsg_type   = SOCK_DIAG_BY_FAMILY;
+    request.header.nlmsg_flags  = NLM_F_REQUEST | NLM_F_DUMP;
+    request.diag.sdiag_family   = AF_INET;
+    request.diag.sdiag_protocol = IPPROTO_UDP;
+    request.diag.idiag_states   = UINT32_MAX;
+    request.diag.idiag_ext      = (1 << (INET_DIAG_SKMEMINFO - 1));
+
+    if(send(socketId , &request , request.header.nlmsg_len , 0) < 0)
+    {
+        close(socketId);
+        return false;
+    }
+
+    sockets->clear();
+
+    while(!done)
+    {
+        int64_t recvLen = recv(socketId , buffer , sizeof(buffer) , 0);
+        if(recvLen <= 0)
+            break;
+
+        for(struct nlmsghdr* header = (struct nlmsghdr*)buffer; NLMSG_OK(header , recvLen); header = NLMSG_NEXT(header , recvLen))
+        {
+            if(header->nlmsg_type == NLMSG_DONE || header->nlmsg_type == NLMSG_ERROR)
+            {
+                done = true;
+                break;
+            }
+
+            struct inet_diag_msg* diag = (struct inet_diag_msg*)NLMSG_DATA(header);
+            SocketMemory          memory;
+
+            memset(&memory , 0 , sizeof(SocketMemory));
+            memory.inode = diag->idiag_inode;
+
+            int attributesLen = header->nlmsg_len - NLMSG_LENGTH(sizeof(struct inet_diag_msg));
+            for(struct rtattr* attribute = (struct rtattr*)(diag + 1); RTA_OK(attribute , attributesLen); attribute = RTA_NEXT(attribute , attributesLen))
+            {
+                if(attribute->rta_type != INET_DIAG_SKMEMINFO || RTA_PAYLOAD(attribute) < (SK_MEMINFO_DROPS + 1) * sizeof(uint32_t))
+                    continue;
+
+                uint32_t* meminfo = (uint32_t*)RTA_DATA(attribute);
+
+                memory.queued = meminfo[SK_MEMINFO_RMEM_ALLOC];
+                memory.rcvbuf = meminfo[SK_MEMINFO_RCVBUF];
+                memory.drops  = meminfo[SK_MEMINFO_DROPS];
+            }
+
+            sockets->push_back(memory);
+        }
+    }
+
+    close(socketId);
+    return done;
+}
@@ -0,0 +1,122 @@
+#ifndef _SOCKET_OPTIONS_H_
+#define _SOCKET_OPTIONS_H_
+
+#include "Utilities.h"
+
+#include <linux/net_tstamp.h>
+
+#define GSO_MAX_SEGMENTS    64      // UDP_MAX_SEGMENTS of the older kernels
+#define GSO_MAX_BYTES       65507   // 65535 - IPv4 header - UDP header
+#define GRO_MAX_BYTES       65535   // a coalesced buffer is never larger than an IP packet
+#define GRO_CONTROL_LEN     CMSG_SPACE(sizeof(int))
+
+#define RX_TIMESTAMP_USER       0   // clock_gettime once the receive returned
+#define RX_TIMESTAMP_SOFTWARE   1   // the kernel , as the datagram came in
+#define RX_TIMESTAMP_HARDWARE   2   // the NIC
+#define RX_TIMESTAMP_SOURCES    3
+#define TIMESTAMPING_CONTROL_LEN CMSG_SPACE(3 * sizeof(struct timespec))   // struct scm_timestamping
+#define RXQ_OVFL_CONTROL_LEN     CMSG_SPACE(sizeof(uint32_t))
+
+//What sock_diag knows about the memory of a socket
+struct SocketMemory
+{
+    uint64_t inode;
+    uint32_t queued;     // bytes waiting in the receive queue
+    uint32_t rcvbuf;
+    uint32_t drops;      // datagrams the socket dropped , mostly with a full receive queue
+};
+
+struct SocketOptions
+{
+    // =======================================================================================================================================
+    // ================================================== Interfaces / Qdiscs ================================================================
+    // =======================================================================================================================================
+
+    //Finds the interface that the kernel routes "destination" through
+    static bool GetEgressInterface(struct sockaddr_in* destination , int* ifIndex , std::string* ifName);
+
+    //Returns the kind ("fq" , "etf" , "mq" ...) of every qdisc attached on the interface
+    static std::vector<std::string> GetQdiscs(int ifIndex);
+
+    static bool HasQdisc(int ifIndex , const char* kind);
+
+    // =======================================================================================================================================
+    // ================================================== Pacing =============================================================================
+    // =======================================================================================================================================
+
+    static bool SetMaxPacingRate(int socketId , uint64_t bytesPerSecond);
+
+    static bool SetTxTime(int socketId , clockid_t clock);
+
+    // =======================================================================================================================================
+    // ================================================== Offloads ===========================================================================
+    // =======================================================================================================================================
+
+    static bool SetUdpSegment(int socketId , uint16_t segmentSize);
+
+    static bool SetZeroCopy(int socketId);
+
+    //The kernel may then hand up the datagrams of a flow coalesced into a single buffer
+    static bool SetUdpGro(int socketId);
+
+    //The size of the datagrams in a coalesced buffer (from its UDP_GRO control message) , 0 if it is a single one
+    static uint16_t GetGroSegmentSize(struct msghdr* header);
+
+    // =======================================================================================================================================
+    // ================================================== Receive Shards =====================================================================
+    // =======================================================================================================================================
+
+    //Before the bind , every socket bound to the port then gets a share of its datagrams
+    static bool SetReusePort(int socketId);
+
+    //The datagrams go to the socket "cpu % groupSize" (in the order they were bound) , where cpu is the
+    //one that received them. Any socket of the group , once it is bound.
+    static bool SetCpuSteering(int socketId , uint16_t groupSize);
+
+    // =======================================================================================================================================
+    // ================================================== Timestamps =========================================================================
+    // =======================================================================================================================================
+
+    //Every datagram then carries the time the kernel (and with "hardware" the NIC) received it
+    static bool SetRxTimestamping(int socketId , bool hardware);
+
+    //The NIC stamps every datagram it receives , needs CAP_NET_ADMIN (left as it is if it already does). The setting
+    //is for the whole host , "previous" gets the one it had (to put back) and "changed" whether it had to change it
+    static bool EnableHardwareRxTimestamps(const std::string& ifName , struct hwtstamp_config* previous , bool* changed);
+
+    //Puts back what EnableHardwareRxTimestamps found
+    static bool RestoreHardwareRxTimestamps(const std::string& ifName , const struct hwtstamp_config* previous);
+
+    //The source of the stamp (RX_TIMESTAMP_USER when the control message has none) , in the clock of its source :
+    //CLOCK_REALTIME for the kernel , the clock of the NIC for the hardware
+    static uint8_t GetRxTimestamp(struct msghdr* header , Time* stamp);
+
+    // =======================================================================================================================================
+    // ================================================== Busy Polling =======================================================================
+    // =======================================================================================================================================
+
+    //A receive on an empty socket polls the queue of the NIC for "usec" instead of returning (or sleeping) right away ,
+    //and the NIC keeps its interrupts off while someone polls it. Above net.core.busy_read it needs CAP_NET_ADMIN.
+    static bool SetBusyPoll(int socketId , uint32_t usec);
+
+    // =======================================================================================================================================
+    // ================================================== Socket Memory ======================================================================
+    // =======================================================================================================================================
+
+    //Every datagram then carries how many the socket has dropped so far
+    static bool SetRxQueueOverflow(int socketId);
+
+    //The drop counter of the socket (from its SO_RXQ_OVFL control message) , false when there is none
+    static bool GetRxQueueOverflow(struct msghdr* header , uint32_t* drops);
+
+    //Raises SO_RCVBUF (or SO_SNDBUF) to "bytes" , as the kernel counts them (twice what setsockopt is given). Past
+    //net.core.rmem_max/wmem_max with CAP_NET_ADMIN. Returns the size that the socket ends up with.
+    static uint32_t GrowBuffer(int socketId , bool receive , uint32_t bytes);
+
+    static uint64_t GetInode(int socketId);
+
+    //The memory of every IPv4 UDP socket , through a sock_diag dump
+    static bool GetUdpMemory(std::vector<SocketMemory>* sockets);
+};
+
+#endif
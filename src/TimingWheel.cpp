@@ -0,0 +1,140 @@
+#include "TimingWheel.h"
+
+TimingWheel::TimingWheel()
+{
+    Setup(0 , 0);
+}
+
+void TimingWheel::Setup(uint32_t numberOfEntries , uint64_t startTick)
+{
+    currentTick = startTick;
+
+    for(int level = 0; level < TIMING_WHEEL_LEVELS; level++)
+    {
+        occupied[level] = 0;
+        for(int slot = 0; slot < TIMING_WHEEL_SLOTS; slot++)
+            slots[level][slot] = TIMING_WHEEL_NONE;
+    }
+
+    entries.assign(numberOfEntries , Entry{0 , TIMING_WHEEL_NONE});
+}
+
+void TimingWheel::Place(uint32_t entry)
+{
+    uint64_t expires = entries[entry].expires;
+    int      level;
+    uint32_t slot;
+
+    //The first level whose slots are wide enough , counted in periods of that level so a slot
+    //is never the one the wheel is currently in (it would only come around again a full turn later)
+    for(level = 0; level < TIMING_WHEEL_LEVELS; level++)
+    {
+        int shift = level * TIMING_WHEEL_BITS;
+
+        if(((expires >> shift) - (currentTick >> shift)) < TIMING_WHEEL_SLOTS)
+            break;
+    }
+
+    if(level == TIMING_WHEEL_LEVELS)
+    {
+        //Beyond the last level , park it in the farthest slot and look again when that cascades
+        level = TIMING_WHEEL_LEVELS - 1;
+        slot  = ((currentTick >> (level * TIMING_WHEEL_BITS)) + TIMING_WHEEL_MASK) & TIMING_WHEEL_MASK;
+    }
+    else
+        slot = (expires >> (level * TIMING_WHEEL_BITS)) & TIMING_WHEEL_MASK;
+
+    entries[entry].next = slots[level][slot];
+    slots[level][slot]  = entry;
+    occupied[level]    |= (1ULL << slot);
+}
+
+void TimingWheel::Cascade(int level)
+{
+    //The wheel just entered the period of this slot , spread its entries over the lower levels
+    uint32_t slot  = (currentTick >> (level * TIMING_WHEEL_BITS)) & TIMING_WHEEL_MASK;
+    uint32_t entry = slots[level][slot];
+
+    slots[level][slot] = TIMING_WHEEL_NONE;
+    occupied[level]   &= ~(1ULL << slot);
+
+    while(entry != TIMING_WHEEL_NONE)
+    {
+        uint32_t next = entries[entry].next;
+
+        Place(entry);
+        entry = next;
+    }
+}
+
+void TimingWheel::Schedule(uint32_t entry , uint64_t tick)
+{
+    entries[entry].expires = std::max(tick , currentTick + 1);
+
+    Place(entry);
+}
+
+void TimingWheel::Advance(uint64_t tick , std::vector<uint32_t>* expired)
+{
+    while(currentTick < tick)
+    {
+        //Nothing anywhere , jump straight to "tick"
+        if(!(occupied[0] | occupied[1] | occupied[2] | occupied[3]))
+        {
+            currentTick = tick;
+            return;
+        }
+
+        currentTick++;
+
+        //Higher levels first , they may refill the slot of the level below that cascades next
+        for(int level = TIMING_WHEEL_LEVELS - 1; level > 0; level--)
+            if(!(currentTick & ((1ULL << (level * TIMING_WHEEL_BITS)) - 1)))
+                Cascade(level);
+
+        uint32_t slot  = currentTick & TIMING_WHEEL_MASK;
+        uint32_t entry = slots[0][slot];
+
+        slots[0][slot] = TIMING_WHEEL_NONE;
+        occupied[0]   &= ~(1ULL << slot);
+
+        while(entry != TIMING_WHEEL_NONE)
+        {
+            uint32_t next = entries[entry].next;
+
+            expired->push_back(entry);
+            entry = next;
+        }
+    }
+}
+
+uint64_t TimingWheel::TicksUntilNextEvent()
+{
+    uint64_t nextEvent = TIMING_WHEEL_NEVER;
+
+    for(int level = 0; level < TIMING_WHEEL_LEVELS; level++)
+    {
+        int      shift   = level * TIMING_WHEEL_BITS;
+        uint32_t current = (currentTick >> shift) & TIMING_WHEEL_MASK;
+
+        if(!occupied[level])
+            continue;
+
+        //Rotate the bitmap so that bit 0 is the slot right after the current one
+        uint64_t rotated  = (occupied[level] >> ((current + 1) & TIMING_WHEEL_MASK)) |
+                            (occupied[level] << ((TIMING_WHEEL_SLOTS - current - 1) & TIMING_WHEEL_MASK));
+        uint64_t distance = __builtin_ctzll(rotated) + 1;
+
+        //The slot of a higher level matters from the start of its period (when it cascades)
+        uint64_t eventTick = (((currentTick >> shift) + distance) << shift);
+
+        nextEvent = std::min(nextEvent , eventTick - currentTick);
+    }
+
+    return nextEvent;
+}
+
+uint64_t TimingWheel::GetCurrentTick()
+{
+    return currentTick;
+}
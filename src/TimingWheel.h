@@ -0,0 +1,54 @@
+#ifndef _TIMING_WHEEL_H_
+#define _TIMING_WHEEL_H_
+
+#include "Utilities.h"
+
+#define TIMING_WHEEL_BITS       6
+#define TIMING_WHEEL_SLOTS      (1 << TIMING_WHEEL_BITS)    // 64 slots per level
+#define TIMING_WHEEL_MASK       (TIMING_WHEEL_SLOTS - 1)
+#define TIMING_WHEEL_LEVELS     4                           // 64us , 4ms , 262ms , 16.7s with 1us ticks
+#define TIMING_WHEEL_TICK_NANO  1000                        // 1us
+#define TIMING_WHEEL_NONE       UINT32_MAX
+#define TIMING_WHEEL_NEVER      UINT64_MAX
+
+//Hierarchical timing wheel over a fixed set of entries (the flows of a sender worker).
+//Every entry is in at most one slot at a time , the lists are intrusive so an entry
+//costs 12 bytes no matter how many flows there are.
+class TimingWheel
+{
+private:
+    struct Entry
+    {
+        uint64_t expires;
+        uint32_t next;
+    };
+
+    uint64_t currentTick;
+
+    uint32_t slots[TIMING_WHEEL_LEVELS][TIMING_WHEEL_SLOTS];
+    uint64_t occupied[TIMING_WHEEL_LEVELS];                     // bitmap of the non empty slots
+
+    std::vector<Entry> entries;
+
+    void Place(uint32_t entry);
+
+    void Cascade(int level);
+
+public:
+    TimingWheel();
+
+    void Setup(uint32_t numberOfEntries , uint64_t startTick);
+
+    //Expires "entry" at "tick" (or on the next tick if that has already passed)
+    void Schedule(uint32_t entry , uint64_t tick);
+
+    //Moves the wheel up to "tick" and appends every entry that expired to "expired"
+    void Advance(uint64_t tick , std::vector<uint32_t>* expired);
+
+    //Ticks until the wheel has something to do , TIMING_WHEEL_NEVER when it is empty
+    uint64_t TicksUntilNextEvent();
+
+    uint64_t GetCurrentTick();
+};
+
+#endif
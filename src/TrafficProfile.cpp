@@ -0,0 +1,436 @@
+#include "TrafficProfile.h"
+
+#include <math.h>
+
+// =======================================================================================================================================
+// ================================================== Parsing Helpers ====================================================================
+// =======================================================================================================================================
+
+static std::string Trim(const std::string& text)
+{
+    size_t begin = text.find_first_not_of(" \t\r\n");
+    size_t end   = text.find_last_not_of(" \t\r\n");
+
+    if(begin == std::string::npos)
+        return "";
+
+    return text.substr(begin , end - begin + 1);
+}
+
+static std::vector<std::string> Split(const std::string& text , char delimiter)
+{
+    std::vector<std::string> parts;
+    size_t begin = 0;
+    size_t end;
+
+    while((end = text.find(delimiter , begin)) != std::string::npos)
+    {
+        parts.push_back(Trim(text.substr(begin , end - begin)));
+        begin = end + 1;
+    }
+    parts.push_back(Trim(text.substr(begin)));
+
+    return parts;
+}
+
+static bool ParseBandwidth(const std::string& text , uint64_t* bandwidth)
+{
+    //bits per second , with an optional k/M/G suffix
+    char*  suffix;
+    double value = strtod(text.c_str() , &suffix);
+
+    if(suffix == text.c_str() || value < 0)
+        return false;
+
+    switch(*suffix)
+    {
+        case 'k': case 'K': value *= 1000.0;       suffix++; break;
+        case 'm': case 'M': value *= 1000000.0;    suffix++; break;
+        case 'g': case 'G': value *= 1000000000.0; suffix++; break;
+        default: break;
+    }
+
+    *bandwidth = (uint64_t)value;
+    return *suffix == '\0';
+}
+
+static bool ParseDuration(const std::string& text , uint64_t* duration)
+{
+    //seconds , or with a s/ms/us suffix
+    char*  suffix;
+    double value = strtod(text.c_str() , &suffix);
+
+    if(suffix == text.c_str() || value <= 0)
+        return false;
+
+    if(!strcmp(suffix , "") || !strcmp(suffix , "s"))
+        value *= ONE_SECOND_TO_NANO;
+    else if(!strcmp(suffix , "ms"))
+        value *= 1000000.0;
+    else if(!strcmp(suffix , "us"))
+        value *= 1000.0;
+    else
+        return false;
+
+    *duration = (uint64_t)value;
+    return *duration > 0;
+}
+
+static bool ParseDutyCycle(const std::string& text , double* dutyCycle)
+{
+    //0.3 or 30%
+    char* suffix;
+
+    *dutyCycle = strtod(text.c_str() , &suffix);
+    if(suffix == text.c_str())
+        return false;
+
+    if(*suffix == '%')
+    {
+        *dutyCycle /= 100.0;
+        suffix++;
+    }
+
+    return *suffix == '\0' && *dutyCycle > 0 && *dutyCycle <= 1.0;
+}
+
+static std::string DescribeBandwidth(double bandwidth)
+{
+    char text[32];
+
+    if(bandwidth >= 1000000000.0)
+        snprintf(text , sizeof(text) , "%gGbit/s" , bandwidth / 1000000000.0);
+    else if(bandwidth >= 1000000.0)
+        snprintf(text , sizeof(text) , "%gMbit/s" , bandwidth / 1000000.0);
+    else
+        snprintf(text , sizeof(text) , "%gkbit/s" , bandwidth / 1000.0);
+
+    return text;
+}
+
+// =======================================================================================================================================
+// ================================================== Profile Phase ======================================================================
+// =======================================================================================================================================
+
+double ProfilePhase::GetBandwidth(uint64_t offset)
+{
+    switch(kind)
+    {
+        case PROFILE_ONOFF:
+        {
+            //On for the first "dutyCycle" of every period
+            return ((offset % periodNano) < (dutyCycle * periodNano)) ? bandwidth : 0.0f;
+        }
+
+        case PROFILE_RAMP:
+        {
+            double progress = std::min<double>(offset , durationNano) / durationNano;
+
+            return bandwidth + (((double)endBandwidth - (double)bandwidth) * progress);
+        }
+
+        default:
+            return bandwidth;
+    }
+}
+
+double ProfilePhase::GetMeanBandwidth()
+{
+    switch(kind)
+    {
+        case PROFILE_ONOFF:
+            return bandwidth * dutyCycle;
+
+        case PROFILE_RAMP:
+            return (bandwidth + endBandwidth) / 2.0;
+
+        default:
+            return bandwidth;
+    }
+}
+
+std::string ProfilePhase::Describe()
+{
+    char text[80];
+
+    switch(kind)
+    {
+        case PROFILE_ONOFF:
+            snprintf(text , sizeof(text) , "onoff %s %g%% of %gms" , DescribeBandwidth(bandwidth).c_str() , dutyCycle * 100.0 , periodNano / 1000000.0);
+            break;
+
+        case PROFILE_POISSON:
+            snprintf(text , sizeof(text) , "poisson %s" , DescribeBandwidth(bandwidth).c_str());
+            break;
+
+        case PROFILE_RAMP:
+            snprintf(text , sizeof(text) , "ramp %s -> %s" , DescribeBandwidth(bandwidth).c_str() , DescribeBandwidth(endBandwidth).c_str());
+            break;
+
+        default:
+            snprintf(text , sizeof(text) , "constant %s" , DescribeBandwidth(bandwidth).c_str());
+            break;
+    }
+
+    return text;
+}
+
+// =======================================================================================================================================
+// ================================================== Traffic Profile ====================================================================
+// =======================================================================================================================================
+
+bool TrafficProfile::ParsePhase(std::string spec)
+{
+    std::vector<std::string> durationParts = Split(spec , '/');
+    std::vector<std::string> arguments;
+    ProfilePhase phase;
+
+    memset(&phase , 0 , sizeof(ProfilePhase));
+
+    if(durationParts.size() != 2 || !ParseDuration(durationParts[1] , &phase.durationNano))
+    {
+        fprintf(stderr, "[PROFILE ~ ERROR] : \"%s\" needs a duration , kind:arguments/duration .\n", spec.c_str());
+        return false;
+    }
+
+    arguments = Split(durationParts[0] , ':');
+    phase.startNano  = GetDuration();
+    phase.periodNano = PROFILE_DEFAULT_PERIOD;
+
+    std::string kind = arguments[0];
+    arguments.erase(arguments.begin());
+
+    bool valid = !arguments.empty() && ParseBandwidth(arguments[0] , &phase.bandwidth);
+
+    if(kind == "constant" || kind == "poisson")
+    {
+        phase.kind = (kind == "constant") ? PROFILE_CONSTANT : PROFILE_POISSON;
+        valid      = valid && arguments.size() == 1 && phase.bandwidth > 0;
+    }
+    else if(kind == "onoff")
+    {
+        phase.kind = PROFILE_ONOFF;
+        valid      = valid && phase.bandwidth > 0 && (arguments.size() == 2 || arguments.size() == 3) &&
+                     ParseDutyCycle(arguments[1] , &phase.dutyCycle) &&
+                     (arguments.size() == 2 || ParseDuration(arguments[2] , &phase.periodNano));
+    }
+    else if(kind == "ramp")
+    {
+        phase.kind = PROFILE_RAMP;
+        valid      = valid && arguments.size() == 2 && ParseBandwidth(arguments[1] , &phase.endBandwidth) &&
+                     (phase.bandwidth > 0 || phase.endBandwidth > 0);
+    }
+    else if(kind == "step")
+    {
+        //Equal constant phases , one per rate
+        uint64_t stepDuration = phase.durationNano / std::max<size_t>(arguments.size() , 1);
+
+        for(uint32_t step = 0; valid && step < arguments.size(); step++)
+        {
+            valid = ParseBandwidth(arguments[step] , &phase.bandwidth) && phase.bandwidth > 0;
+
+            phase.kind         = PROFILE_CONSTANT;
+            phase.startNano    = GetDuration();
+            phase.durationNano = stepDuration;
+
+            if(valid)
+                phases.push_back(phase);
+        }
+
+        if(!valid)
+            fprintf(stderr, "[PROFILE ~ ERROR] : \"%s\" , a step phase is step:rate:rate:.../duration .\n", spec.c_str());
+        return valid;
+    }
+    else
+    {
+        fprintf(stderr, "[PROFILE ~ ERROR] : unknown phase \"%s\" (constant , onoff , poisson , ramp or step).\n", kind.c_str());
+        return false;
+    }
+
+    if(!valid)
+    {
+        fprintf(stderr, "[PROFILE ~ ERROR] : \"%s\" , expected constant:rate , onoff:rate:duty[:period] , poisson:rate or ramp:rate:rate .\n", spec.c_str());
+        return false;
+    }
+
+    phases.push_back(phase);
+    return true;
+}
+
+bool TrafficProfile::Parse(std::string spec)
+{
+    for(auto phase : Split(spec , ','))
+    {
+        if(phase.empty())
+            continue;
+
+        if(!ParsePhase(phase))
+            return false;
+    }
+
+    if(phases.size() > PROFILE_MAX_PHASES)
+    {
+        fprintf(stderr, "[PROFILE ~ ERROR] : at most %d phases.\n", PROFILE_MAX_PHASES);
+        return false;
+    }
+
+    return true;
+}
+
+bool TrafficProfile::Load(const char* fileName)
+{
+    FILE* profileFile = fopen(fileName , "r");
+    char  line[512];
+
+    if(!profileFile)
+    {
+        fprintf(stderr, "[PROFILE ~ ERROR] : unable to open file with name : %s .\n", fileName);
+        return false;
+    }
+
+    while(fgets(line , sizeof(line) , profileFile))
+    {
+        std::string spec = line;
+
+        if(spec.find('#') != std::string::npos)
+            spec = spec.substr(0 , spec.find('#'));
+
+        if(!Parse(spec))
+        {
+            fclose(profileFile);
+            return false;
+        }
+    }
+
+    fclose(profileFile);
+    return true;
+}
+
+bool TrafficProfile::IsEmpty()
+{
+    return phases.empty();
+}
+
+uint64_t TrafficProfile::GetDuration()
+{
+    if(phases.empty())
+        return 0;
+
+    return phases.back().startNano + phases.back().durationNano;
+}
+
+uint32_t TrafficProfile::GetPhaseIndex(uint64_t offset)
+{
+    //The last phase that started , the phases are in order
+    auto next = std::upper_bound(phases.begin() , phases.end() , offset ,
+                                 [](uint64_t time , const ProfilePhase& phase) { return time < phase.startNano; });
+
+    return (next == phases.begin()) ? 0 : (next - phases.begin()) - 1;
+}
+
+std::vector<ProfilePhase>& TrafficProfile::GetPhases()
+{
+    return phases;
+}
+
+uint64_t TrafficProfile::GetBandwidth(uint64_t offset , uint64_t* resume)
+{
+    uint32_t      index = GetPhaseIndex(offset);
+    ProfilePhase* phase = &phases[index];
+    uint64_t      inPhase = offset - phase->startNano;
+    double        bandwidth = phase->GetBandwidth(inPhase);
+
+    if(bandwidth >= 1.0)
+        return (uint64_t)bandwidth;
+
+    //Off until the next period of an on/off phase , a ramp at 0 is looked at again shortly
+    if(phase->kind == PROFILE_ONOFF)
+        *resume = offset - (inPhase % phase->periodNano) + phase->periodNano;
+    else
+        *resume = offset + PROFILE_IDLE_NANO;
+
+    if(index + 1 < phases.size())
+        *resume = std::min(*resume , phases[index + 1].startNano);
+
+    return 0;
+}
+
+double TrafficProfile::GetGap(uint64_t offset , uint64_t bits , std::mt19937_64& random)
+{
+    ProfilePhase* phase   = &phases[GetPhaseIndex(offset)];
+    uint64_t      inPhase = offset - phase->startNano;
+
+    switch(phase->kind)
+    {
+        case PROFILE_POISSON:
+        {
+            //Exponential gaps with the mean of the constant rate
+            std::exponential_distribution<double> exponential(1.0);
+
+            return (bits * (double)ONE_SECOND_TO_NANO / phase->bandwidth) * exponential(random);
+        }
+
+        case PROFILE_RAMP:
+        {
+            if(inPhase >= phase->durationNano)
+                return bits * (double)ONE_SECOND_TO_NANO / phase->endBandwidth;
+
+            //Solve bits = integral of (rate + slope * t) dt over the gap (in bits and nanoseconds)
+            double rate  = phase->GetBandwidth(inPhase) / ONE_SECOND_TO_NANO;
+            double slope = (((double)phase->endBandwidth - (double)phase->bandwidth) / ONE_SECOND_TO_NANO) / phase->durationNano;
+            double discriminant = (rate * rate) + (2.0 * slope * bits);
+
+            //A ramp down reaches 0 first , wait for the end of the phase
+            if(discriminant < 0)
+                return phase->durationNano - inPhase;
+
+            //The stable form of (-rate + sqrt(discriminant)) / slope
+            if(rate + sqrt(discriminant) <= 0)
+                return PROFILE_IDLE_NANO;
+
+            return (2.0 * bits) / (rate + sqrt(discriminant));
+        }
+
+        default:
+            return bits * (double)ONE_SECOND_TO_NANO / phase->bandwidth;
+    }
+}
+
+double TrafficProfile::GetMeanBandwidth(uint64_t duration)
+{
+    double bits = 0.0f;
+
+    if(!duration)
+        return 0.0f;
+
+    for(uint32_t index = 0; index < phases.size(); index++)
+    {
+        ProfilePhase* phase   = &phases[index];
+        uint64_t      covered = GetPhaseDuration(index , duration);
+        uint64_t      nominal = std::min(covered , phase->durationNano);
+
+        bits += phase->GetMeanBandwidth() * nominal;
+
+        //The last phase holds (a ramp at its final rate)
+        if(covered > nominal)
+            bits += ((phase->kind == PROFILE_RAMP) ? phase->endBandwidth : phase->GetMeanBandwidth()) * (covered - nominal);
+    }
+
+    return bits / duration;
+}
+
+uint64_t TrafficProfile::GetPhaseDuration(uint32_t phase , uint64_t duration)
+{
+    uint64_t start = phases[phase].startNano;
+    uint64_t end;
+
+    if(start >= duration)
+        return 0;
+
+    if(phase + 1 == phases.size())
+        end = duration;
+    else
+        end = std::min(start + phases[phase].durationNano , duration);
+
+    return end - start;
+}
@@ -0,0 +1,78 @@
+#ifndef _TRAFFIC_PROFILE_H_
+#define _TRAFFIC_PROFILE_H_
+
+#include "Utilities.h"
+
+#include <random>
+
+#define PROFILE_CONSTANT        0
+#define PROFILE_ONOFF           1
+#define PROFILE_POISSON         2
+#define PROFILE_RAMP            3
+
+#define PROFILE_MAX_PHASES      256
+#define PROFILE_DEFAULT_PERIOD  100000000  // 100ms , on/off period when none is given
+#define PROFILE_IDLE_NANO       1000000    // 1ms , how often a stream looks again at a rate of 0
+
+struct ProfilePhase
+{
+    uint8_t  kind;
+    uint64_t startNano;         // offset from the start of the test
+    uint64_t durationNano;
+
+    uint64_t bandwidth;         // constant rate , Poisson mean , on/off "on" rate , ramp start
+    uint64_t endBandwidth;      // ramp end
+    double   dutyCycle;         // on/off , the fraction of every period that sends
+    uint64_t periodNano;        // on/off
+
+    //The rate at "offset" into the phase , 0 while an on/off phase is off
+    double GetBandwidth(uint64_t offset);
+
+    //The average rate of the phase
+    double GetMeanBandwidth();
+
+    std::string Describe();
+};
+
+//A bandwidth schedule for every stream of the client , phases one after the other.
+//The last phase holds until the end of the test.
+//
+//   constant:10M/5 , onoff:50M:30%:100ms/5 , poisson:20M/5 , ramp:1M:100M/10 , step:1M:5M:10M/9
+//
+//Every phase is "kind:arguments/duration" (seconds , or with a s/ms/us suffix) , rates are bits per second
+//with an optional k/M/G suffix. A step phase splits its duration into equal constant phases.
+class TrafficProfile
+{
+private:
+    std::vector<ProfilePhase> phases;
+
+    bool ParsePhase(std::string spec);
+
+public:
+    bool Parse(std::string spec);
+
+    //The same phases , one per line ('#' starts a comment)
+    bool Load(const char* fileName);
+
+    bool IsEmpty();
+
+    uint64_t GetDuration();
+
+    uint32_t GetPhaseIndex(uint64_t offset);
+
+    std::vector<ProfilePhase>& GetPhases();
+
+    //The rate at "offset" , 0 while the phase is off (then "resume" is when it may send again)
+    uint64_t GetBandwidth(uint64_t offset , uint64_t* resume);
+
+    //How long "bits" take on the wire starting at "offset". Random for Poisson , integrated over the slope for a ramp.
+    double GetGap(uint64_t offset , uint64_t bits , std::mt19937_64& random);
+
+    //The bandwidth a stream should average over the first "duration" nanoseconds
+    double GetMeanBandwidth(uint64_t duration);
+
+    //How much of the first "duration" nanoseconds every phase covers
+    uint64_t GetPhaseDuration(uint32_t phase , uint64_t duration);
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <sys/resource.h>
 
 #include "Utilities.h"
 
@@ -12,6 +13,23 @@ void SystemClock::GetSystemTime(Time* fill)
         fprintf(stderr,"[Error ~ Time] : unable to get system time!\n");
 }
 
+void SystemClock::GetThreadCpuTime(Time* fill)
+{
+    if( clock_gettime(CLOCK_THREAD_CPUTIME_ID , fill) < 0)
+        fprintf(stderr,"[Error ~ Time] : unable to get the cpu time of the thread!\n");
+}
+
+int64_t SystemClock::GetRealtimeOffset()
+{
+    Time monotonic;
+    Time realtime;
+
+    if( clock_gettime(CLOCK_MONOTONIC , &monotonic) < 0 || clock_gettime(CLOCK_REALTIME , &realtime) < 0)
+        fprintf(stderr,"[Error ~ Time] : unable to get system time!\n");
+
+    return (int64_t)GetTimeInNanoSeconds(&realtime) - (int64_t)GetTimeInNanoSeconds(&monotonic);
+}
+
 Time SystemClock::GetElapsedTime(Time* time1 , Time* time2)
 {
     Time diff;
@@ -62,6 +80,16 @@ uint64_t SystemClock::GetTimeInNanoSeconds(Time* time)
     return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
 }
 
+Time SystemClock::GetTimeFromNanoSeconds(uint64_t nano)
+{
+    Time time;
+
+    time.tv_sec  = nano / ONE_SECOND_TO_NANO;
+    time.tv_nsec = nano % ONE_SECOND_TO_NANO;
+
+    return time;
+}
+
 std::size_t SystemClock::Serialize(Time* time , uint8_t* buffer, std::size_t padding)
 {
     uint32_t sendSeconds;
@@ -114,7 +142,39 @@ void PrintUsage()
                 "                     communication TCP channel of the server. In client mode, the argument\n"
                 "                     specifies the server port to connect to.\n"
                 "                -i   The interval in seconds to print information for the progress of the experiment.\n"
-                "                -f   Specifies the file that the results will be stored.");
+                "                -f   Specifies the file that the results will be stored.\n"
+                "         --threads   Number of threads that pace (client) or receive (server) the streams\n"
+                "                     (default: one per core).\n"
+                "           --batch   Number of datagrams handed to the kernel with a single sendmmsg call (client) , or\n"
+                "                     returned by a single recvmmsg call (server , reports how full the calls were).\n"
+                "        --affinity   Pin the stream threads , one CPU each , round robin over a CPU list (0-3,8) or over\n"
+                "                     the CPUs of the NUMA node of the network interface (\"nic\").\n"
+                "--control-affinity   Pin the TCP control thread to a CPU list or to the node of the interface (\"nic\").\n"
+                "        --io-uring   Use io_uring for the datagrams : a multishot recv into provided buffers on the server ,\n"
+                "                     the batches of every due stream in a single submission on the client (falls back to\n"
+                "                     select/sendmmsg when the kernel does not support it). The TCP control connection\n"
+                "                     stays on epoll (server) and select (client).\n"
+                "     --sockbuf-cap   Largest SO_RCVBUF (server , doubled whenever a stream socket drops) or SO_SNDBUF\n"
+                "                     (client) in bytes (default: 64MB , past net.core.rmem_max/wmem_max as root).");
+    fprintf(stdout,   
+                "\n"
+                "Server Options:\n"
+                "          --shards   Number of SO_REUSEPORT sockets per stream port , every one drained by its own\n"
+                "                     receiver thread (use --threads and --affinity to give each its own CPU).\n"
+                "    --shard-by-cpu   Steer the datagrams to the shard of the CPU that received them (a BPF program) ,\n"
+                "                     instead of the flow hash (a single flow then stays on a single shard).\n"
+                "             --gro   Let the kernel coalesce the datagrams of a stream (UDP_GRO) , the receivers split the\n"
+                "                     buffers again and measure every datagram (not with --io-uring).\n"
+                "   --rx-timestamps   Take the arrival times from the kernel (\"sw\") or from the NIC (\"hw\" , its clock kept\n"
+                "                     in step with the system clock by phc2sys) instead of after the receive (not with --io-uring).\n"
+                "       --busy-poll   Microseconds that a receiver keeps polling its empty sockets (SO_BUSY_POLL) before it\n"
+                "                     sleeps , against the wakeup latency of -d tests. Give every receiver a core (--affinity).\n"
+                "          --bucket   Length in ms of the intervals that the streams are counted in (default: 100) , the\n"
+                "                     reports (-i and the client ones) are over the intervals since the last one.\n"
+                "       --retention   Seconds of intervals that every stream keeps , for the sliding window , the EWMA\n"
+                "                     rate and the heatmap (default: 60).\n"
+                "         --heatmap   Append the time x latency heatmap of every -d test to a file , a line per interval\n"
+                "                     with its datagrams per latency bin (powers of two of microseconds).");
     fprintf(stdout,   
                 "\n"
                 "Client Options:\n"
@@ -124,10 +184,36 @@ void PrintUsage()
                 "                -n   Number of parallel data streams that the client should create.\n"
                 "                -t   Experiment duration in seconds.\n"
                 "                -d   Measure the one way delay, instead of throughput, jitter and packet loss.\n"
-                "                -w   Wait duration in seconds before starting the data transmission.");
+                "                -w   Wait duration in seconds before starting the data transmission.\n"
+                "           --burst   Size in packets of the token bucket that paces every stream (default: 8 , at least a batch).\n"
+                "   --kernel-pacing   Let the kernel pace the streams , \"rate\" (SO_MAX_PACING_RATE , fq qdisc) or\n"
+                "                     \"txtime\" (SO_TXTIME launch times , fq/etf qdisc).\n"
+                "             --gso   Send every batch as UDP_SEGMENT super buffers that the kernel splits into datagrams.\n"
+                "        --zerocopy   Send with MSG_ZEROCOPY from a ring of pinned buffers (for large datagrams).\n"
+                "       --hugepages   Back the packet pools with hugepages.\n"
+                "         --profile   Bandwidth schedule of every stream , comma separated phases \"kind:args/duration\":\n"
+                "                     constant:10M/5 , onoff:50M:30%%:100ms/5 , poisson:20M/5 , ramp:1M:100M/10 , step:1M:5M/4\n"
+                "                     (without -t the experiment lasts as long as the profile).\n"
+                "    --profile-file   Read the profile from a file , one phase per line.\n"
+                "          --search   Search the highest rate (up to -b) that loses at most this percentage (RFC 2544) ,\n"
+                "                     with a binary search of short trials (-t , default: 1s) over the same connection.\n"
+                "    --search-sizes   Comma separated packet sizes to search (default: the one of -l).");
     fprintf(stdout,   
                 "\n"
                 "Other Options:\n"
                 "                -h   Prints this help message.\n"
                 "\n");
-}
\ No newline at end of file
+}
+
+void RaiseFileDescriptorLimit()
+{
+    struct rlimit limit;
+
+    if(getrlimit(RLIMIT_NOFILE , &limit) < 0 || limit.rlim_cur == limit.rlim_max)
+        return;
+
+    //The soft limit (usually 1024) is what runs out first with thousands of streams
+    limit.rlim_cur = limit.rlim_max;
+    if(setrlimit(RLIMIT_NOFILE , &limit) < 0)
+        perror("[NERF ~ INFO] : unable to raise the open files limit");
+}
@@ -5,7 +5,10 @@
 // =================================================  Shared Includes ====================================================================
 // =======================================================================================================================================
 
+#include <cstdio>
 #include <cstring>
+#include <string>
+#include <vector>
 #include <cstdint>
 #include <thread>
 #include <chrono>
@@ -27,13 +30,18 @@
 #define DEFAULT_PRINT_IN_FILE              0       // false
 #define DEFAULT_INTERVAL_TO_PRINT          0       // print only in the end
 #define DEFAULT_BANDWIDTH                  1000000 // 1Mbits/sec
+#define DEFAULT_BATCH_SIZE                 1       // one datagram per syscall
+#define MAX_BATCH_SIZE                     1024    // UIO_MAXIOV , the sendmmsg limit
+#define DEFAULT_SOCKET_BUFFER_CAP          67108864 // 64MB , SO_RCVBUF/SO_SNDBUF never grow past it
 
 #define ONE_SECOND_TO_NANO                 1000000000
+#define CACHE_LINE_SIZE                    64
 
 #define UDP_HEADER_SIZE                     8
 #define TCP_HEADER_SIZE                     20
 #define IPV4_HEADER_SIZE                    20
 #define ETH_HEADER_SIZE                     26
+#define ETH_MAC_HEADER_SIZE                 14      // what the qdiscs see of the ethernet header
 
 #define HEADERS_FROM_THE_LAYERS            (UDP_HEADER_SIZE + IPV4_HEADER_SIZE + ETH_HEADER_SIZE)
 
@@ -53,6 +61,13 @@ struct SystemClock
     
     static uint64_t GetTimeInNanoSeconds(Time* time);
 
+    static Time GetTimeFromNanoSeconds(uint64_t nano);
+
+    static void GetThreadCpuTime(Time* fill);
+
+    //CLOCK_REALTIME - CLOCK_MONOTONIC (the clock of "Time") in nanoseconds , the kernel stamps in the first
+    static int64_t GetRealtimeOffset();
+
     static std::size_t Serialize(Time* time , uint8_t* buffer , std::size_t padding);
 
     static std::size_t Derialize(Time* time , uint8_t* buffer , std::size_t padding);
@@ -84,4 +99,6 @@ template <typename T> static inline T reverseBytes(const T &input)
 
 void PrintUsage();
 
+void RaiseFileDescriptorLimit();
+
 #endif
\ No newline at end of file
@@ -0,0 +1,111 @@
+#include "ZeroCopy.h"
+
+#include <poll.h>
+#include <linux/errqueue.h>
+
+ZeroCopy::ZeroCopy()
+{
+    socketId    = -1;
+    nextId      = 0;
+    idsPerSlot  = 0;
+    idMask      = 0;
+    completions = 0;
+    copied      = 0;
+}
+
+void ZeroCopy::Setup(int _socketId , uint32_t slots , uint32_t _idsPerSlot)
+{
+    socketId    = _socketId;
+    nextId      = 0;
+    idsPerSlot  = _idsPerSlot;
+    completions = 0;
+    copied      = 0;
+
+    pendingSends.assign(slots , 0);
+
+    //The ids wrap at 2^32 , a ring of a power of two keeps them on the same entries across the wrap
+    uint32_t ringSize = 1;
+    while(ringSize < slots * idsPerSlot)
+        ringSize <<= 1;
+
+    idMask = ringSize - 1;
+    idToSlot.assign(ringSize , 0);
+}
+
+bool ZeroCopy::IsFree(uint32_t slot)
+{
+    return !pendingSends[slot];
+}
+
+bool ZeroCopy::WaitForSlot(uint32_t slot)
+{
+    Reap();
+
+    while(pendingSends[slot])
+    {
+        struct pollfd pollDescriptor;
+
+        //POLLERR is always reported , there is nothing else to ask for
+        pollDescriptor.fd      = socketId;
+        pollDescriptor.events  = 0;
+        pollDescriptor.revents = 0;
+
+        if(poll(&pollDescriptor , 1 , ZEROCOPY_WAIT_MS) < 0)
+            return false;
+
+        Reap();
+    }
+
+    return true;
+}
+
+void ZeroCopy::Submitted(uint32_t slot , uint32_t sends)
+{
+    for(uint32_t send = 0; send < sends; send++ , nextId++)
+        idToSlot[nextId & idMask] = slot;
+
+    pendingSends[slot] += sends;
+}
+
+void ZeroCopy::Reap()
+{
+    while(1)
+    {
+        struct msghdr   message;
+        struct cmsghdr* control;
+        uint8_t         controlBuffer[CMSG_SPACE(sizeof(struct sock_extended_err) + sizeof(struct sockaddr_in))];
+
+        memset(&message , 0 , sizeof(struct msghdr));
+        message.msg_control    = controlBuffer;
+        message.msg_controllen = sizeof(controlBuffer);
+
+        //Reads from the error queue never block
+        if(recvmsg(socketId , &message , MSG_ERRQUEUE) < 0)
+            return;
+
+        for(control = CMSG_FIRSTHDR(&message); control; control = CMSG_NXTHDR(&message , control))
+        {
+            struct sock_extended_err error;
+
+            if(control->cmsg_level != SOL_IP || control->cmsg_type != IP_RECVERR)
+                continue;
+
+            memcpy(&error , CMSG_DATA(control) , sizeof(struct sock_extended_err));
+            if(error.ee_errno || error.ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+                continue;
+
+            //The kernel releases the ids [ee_info , ee_data] at once
+            for(uint32_t id = error.ee_info; id != error.ee_data + 1; id++)
+            {
+                uint32_t slot = idToSlot[id & idMask];
+
+                if(pendingSends[slot])
+                    pendingSends[slot]--;
+
+                completions++;
+                if(error.ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+                    copied++;
+            }
+        }
+    }
+}
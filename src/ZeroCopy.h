@@ -0,0 +1,44 @@
+#ifndef _ZERO_COPY_H_
+#define _ZERO_COPY_H_
+
+#include "Utilities.h"
+
+#define ZEROCOPY_RING_SLOTS     64      // batches that may be in flight before the sender waits for the kernel
+#define ZEROCOPY_WAIT_MS        100     // poll timeout while waiting for a slot , so the sender can still notice a stop
+
+//Keeps track of which slots of a send ring the kernel still reads from (MSG_ZEROCOPY).
+//Every successful zerocopy send call gets the next 32bit id of the socket and the kernel
+//releases the ids , in ranges , through the error queue of the socket.
+class ZeroCopy
+{
+private:
+    int socketId;
+
+    uint32_t nextId;
+    uint32_t idsPerSlot;
+    uint32_t idMask;
+
+    std::vector<uint32_t> pendingSends;     // per slot
+    std::vector<uint32_t> idToSlot;         // ring , big enough for all the ids that can be in flight (a power of two)
+
+public:
+    uint64_t completions;
+    uint64_t copied;                        // completions that the kernel had to copy after all
+
+    ZeroCopy();
+
+    void Setup(int _socketId , uint32_t slots , uint32_t _idsPerSlot);
+
+    bool IsFree(uint32_t slot);
+
+    //Blocks until the kernel releases "slot" , returns false on a socket error
+    bool WaitForSlot(uint32_t slot);
+
+    //"sends" zerocopy send calls went out from "slot"
+    void Submitted(uint32_t slot , uint32_t sends);
+
+    //Drains the completion notifications that are waiting in the error queue
+    void Reap();
+};
+
+#endif